@@ -0,0 +1,28 @@
+#!/bin/sh
+# Runs the same conf with the QGSP_BERT and the optical physics lists and
+# prints startup time, event rate and per-channel npe of each.
+#
+#   ../bench/physics_list.sh <conf file> [events]
+#
+# Run from the build directory. Both runs use the same beam entries
+# (beam_sampling is forced to sequential), so the npe must agree within
+# statistics.
+
+set -e
+conf=$1
+events=${2:-2000}
+if [ -z "$conf" ]; then
+  echo "Usage: $0 <conf file> [events]" >&2
+  exit 1
+fi
+
+for list in QGSP_BERT optical; do
+  tmpconf=bench_${list}.conf
+  grep -v -E '^[[:space:]]*(physics_list|beam_sampling|progress_interval)[[:space:]]' "$conf" > "$tmpconf"
+  printf 'physics_list %s\nbeam_sampling sequential\nprogress_interval 0\n' "$list" >> "$tmpconf"
+  printf '/run/beamOn %s\n' "$events" > bench_${list}.mac
+
+  echo "=== $list"
+  ./SACOpticalSim "$tmpconf" bench_${list}.root bench_${list}.mac 2>&1 |
+    grep -E 'Startup time|Done|npe/event per channel'
+done
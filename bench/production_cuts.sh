@@ -0,0 +1,55 @@
+#!/bin/sh
+# Runs the same conf with several production cuts in the passive and air
+# regions and prints the event rate, the total npe/event and its bias with
+# respect to the conf as given.
+#
+#   ../bench/production_cuts.sh <conf file> [events] [cuts in mm...]
+#
+# Run from the build directory. All runs use the same beam entries
+# (beam_sampling is forced to sequential). The bias is only significant if
+# it is larger than the statistical error of the npe.
+
+set -e
+conf=$1
+events=${2:-2000}
+if [ -z "$conf" ]; then
+  echo "Usage: $0 <conf file> [events] [cuts in mm...]" >&2
+  exit 1
+fi
+shift
+[ $# -gt 0 ] && shift
+cuts=${*:-"1 3 10 30"}
+
+# total npe/event from the "npe/event per channel : 0:x 1:y ..." line
+total_npe() {
+  grep 'npe/event per channel' "$1" |
+    awk -F: '{ s = 0; for (i = 3; i <= NF; ++i) s += $i; print s }'
+}
+
+run() {
+  name=$1
+  tmpconf=bench_${name}.conf
+  grep -v -E '^[[:space:]]*(beam_sampling|progress_interval|cut_passive|cut_air)[[:space:]]' "$conf" > "$tmpconf"
+  printf 'beam_sampling sequential\nprogress_interval 0\n' >> "$tmpconf"
+  if [ "$name" != reference ]; then
+    # keep the conf's own cuts for the reference run
+    printf 'cut_passive %s\ncut_air %s\n' "$2" "$2" >> "$tmpconf"
+  else
+    grep -E '^[[:space:]]*(cut_passive|cut_air)[[:space:]]' "$conf" >> "$tmpconf" || true
+  fi
+  printf '/run/beamOn %s\n' "$events" > bench_${name}.mac
+  ./SACOpticalSim "$tmpconf" bench_${name}.root bench_${name}.mac > bench_${name}.log 2>&1
+}
+
+run reference
+reference=$(total_npe bench_reference.log)
+echo "=== reference: npe/event $reference"
+grep -E 'Done' bench_reference.log
+
+for cut in $cuts; do
+  run cut_$cut "$cut"
+  npe=$(total_npe bench_cut_$cut.log)
+  echo "=== cut_passive = cut_air = $cut mm: npe/event $npe, bias" \
+    "$(awk -v a="$npe" -v b="$reference" 'BEGIN { printf "%+.2f%%", b > 0 ? 100 * (a / b - 1) : 0 }')"
+  grep -E 'Done' bench_cut_$cut.log
+done
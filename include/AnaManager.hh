@@ -1,6 +1,7 @@
 #ifndef ANA_MANAGER_HH
 #define ANA_MANAGER_HH
 
+#include <memory>
 #include <vector>
 
 #include <G4ThreeVector.hh>
@@ -11,6 +12,10 @@
 #include "TTree.h"
 #include "TVector3.h"
 
+#include "AsyncTreeWriter.hh"
+#include "EventRecord.hh"
+#include "HitColumn.hh"
+
 class AnaManager
 {
 public:
@@ -23,31 +28,26 @@ private:
   AnaManager &operator=(const AnaManager &);
 
 private:
-  G4String m_output_rootfile_path;
+  // output path given on the command line, shared by master and workers
+  static G4String m_output_rootfile_path;
   TFile *m_file;
   TTree *m_tree;
-  G4int m_evnum;
-  G4int m_nhit_pmt;
-  G4int m_cerenkov_all;
-  G4int m_cerenkov_aerogel;
-  G4double m_beam_energy;
-  G4double m_beam_mom_x;
-  G4double m_beam_mom_y;
-  G4double m_beam_mom_z;
-  G4double m_beam_pos_x;
-  G4double m_beam_pos_y;
-  G4double m_beam_pos_z;
 
-  // std::vector<TVector3> m_pos;
-  std::vector<G4double> m_pos_x;
-  std::vector<G4double> m_pos_y;
-  std::vector<G4double> m_pos_z;
-  std::vector<G4double> m_time;
-  std::vector<G4double> m_energy;
-  std::vector<G4double> m_wave_length;
-  std::vector<G4int> m_particle_id;
-  std::vector<G4int> m_seg;
-  std::vector<G4int> m_detect_flag;
+  // The simulation fills *m_current. In synchronous mode that is
+  // m_tree_record itself, the record the branches point at; with the
+  // async writer it is a record borrowed from the writer's pool.
+  EventRecord m_tree_record;
+  EventRecord *m_current;
+  std::unique_ptr<AsyncTreeWriter> m_writer;
+  // pos_x/y/z, time, energy and wave_length in the configured precision
+  std::vector<HitColumn> m_hit_columns;
+  // wave_length is only filled when its column is booked
+  G4bool m_store_wave_length;
+  G4int m_verbose;
+  // detected photoelectrons of this run, indexed by PMT channel (seg)
+  std::vector<G4long> m_npe_per_channel;
+
+  void FillTree();
 
 public:
   void BeginOfRunAction(const G4Run *);
@@ -56,13 +56,41 @@ public:
   void EndOfEventAction(const G4Event *);
 
   void ResetContainer();
+  // photoelectrons (detect_flag 1) of the event being filled
+  G4int GetNumOfDetectedPhotons() const;
+  const std::vector<G4long> &GetNumOfPEPerChannel() const { return m_npe_per_channel; }
+  // called by PMTSD for every photon reaching a PMT window
+  void AddPMTHit(const G4ThreeVector &pos, G4double time, G4double energy,
+                 G4double wave_length, G4int particle_id, G4int seg,
+                 G4int detect_flag);
+  // absorber: SteppingAction::Absorber
+  void AddAbsorbedPhoton(G4int absorber);
+  // policy: SteppingAction::KillPolicy
+  void AddKilledPhoton(G4int policy);
   void SetNumOfCerenkovAll(G4int cerenkov_all);
   void SetNumOfCerenkovAerogel(G4int cerenkov_aerogel);
+  void SetNumOfCerenkovGlass(G4int cerenkov_glass);
+  void SetNumOfCerenkovTeflon(G4int cerenkov_teflon);
+  void SetNumOfCerenkovPOM(G4int cerenkov_pom);
+  void SetNumOfCerenkovBlackSheet(G4int cerenkov_blacksheet);
+  void SetNumOfCerenkovSkippedMaterial(G4int skipped_material);
+  void SetNumOfCerenkovSkippedBand(G4int skipped_band);
+  // the optical photons of the event were dropped, see StackingAction
+  void SetPrefiltered();
+  void SetEventSeed(G4long event_seed);
   void SetBeamEnergy(G4double beam_energy);
   void SetBeamMomentum(G4ThreeVector beam_momentum);
   void SetBeamPosition(G4ThreeVector beam_position);
-  void SetOutputRootfilePath(G4String output_rootfile_path);
-  G4String GetOutputRootfilePath();
+  static void SetOutputRootfilePath(G4String output_rootfile_path);
+  static G4String GetOutputRootfilePath();
+
+  // per-thread and per-job output files and their merge into the output path
+  static G4String GetPartFilePath(const G4String &tag);
+  static G4bool MergePartFiles(const std::vector<G4String> &parts);
+
+private:
+  G4bool IsMergeMaster() const;
+  void MergeWorkerFiles();
 };
 
 #endif
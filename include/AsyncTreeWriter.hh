@@ -0,0 +1,55 @@
+#ifndef ASYNC_TREE_WRITER_HH
+#define ASYNC_TREE_WRITER_HH
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "globals.hh"
+#include "EventRecord.hh"
+
+// Fills and flushes a TTree on a dedicated thread. The simulation thread
+// takes a free record with Acquire(), fills it and hands it back with
+// Submit(). It only blocks when all preallocated records are still queued.
+class AsyncTreeWriter
+{
+public:
+  // tree_record is the record the tree branches point at, fill writes it
+  AsyncTreeWriter(EventRecord &tree_record, std::function<void()> fill,
+                  std::size_t depth);
+  ~AsyncTreeWriter();
+
+  EventRecord *Acquire();
+  void Submit(EventRecord *record);
+  // drains the queue and joins the writer thread
+  void Stop();
+  void PrintStats() const;
+
+private:
+  void Run();
+
+  EventRecord &m_tree_record;
+  std::function<void()> m_fill;
+  std::vector<std::unique_ptr<EventRecord>> m_pool;
+
+  std::thread m_thread;
+  std::mutex m_mutex;
+  std::condition_variable m_cv_full; // writer waits for records
+  std::condition_variable m_cv_free; // simulation waits for free records
+  std::deque<EventRecord *> m_full;
+  std::vector<EventRecord *> m_free;
+  G4bool m_stop;
+
+  // statistics
+  G4long m_nsubmit;
+  std::size_t m_max_depth;
+  G4double m_sum_depth;
+  G4double m_stall_time;  // simulation blocked on a full queue [s]
+  G4double m_write_time;  // writer busy in TTree::Fill [s]
+};
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef BEAM_PHASE_SPACE_HH
+#define BEAM_PHASE_SPACE_HH
+
+#include <cstdint>
+
+// Binary beam phase-space file written by convertBeamProfile and mapped
+// read-only by BeamProfile. Native byte order, laid out as
+//
+//   BeamFileHeader
+//   BeamRunIndex[nruns]
+//   BeamEntry[...]      entries of each run, at BeamRunIndex::offset
+//
+// Only plain structs here, the converter is built without Geant4.
+namespace BeamPhaseSpace
+{
+  const char kMagic[8] = {'S', 'A', 'C', 'B', 'E', 'A', 'M', '1'};
+
+  struct BeamFileHeader
+  {
+    char magic[8];
+    std::uint32_t nruns;
+    std::uint32_t entry_size; // sizeof(BeamEntry), guards against layout changes
+  };
+
+  struct BeamRunIndex
+  {
+    std::int32_t run;
+    std::uint32_t reserved;
+    std::uint64_t offset; // bytes from the start of the file
+    std::uint64_t nentries;
+  };
+
+  // x, y in mm, x' = dx/dz and y' = dy/dz, p in GeV/c (0 = not measured)
+  struct BeamEntry
+  {
+    float x, y, xp, yp, p;
+  };
+}
+
+#endif
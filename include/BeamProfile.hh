@@ -0,0 +1,59 @@
+#ifndef BEAM_PROFILE_HH
+#define BEAM_PROFILE_HH
+
+#include <memory>
+#include <vector>
+
+#include "globals.hh"
+#include "BeamPhaseSpace.hh"
+#include "ConfManager.hh"
+
+// Beam phase space shared read-only by every PrimaryGeneratorAction, so no
+// file I/O happens during event generation. A binary beam file (.bin, see
+// BeamPhaseSpace.hh) is mapped into memory: opening it costs nothing in
+// proportion to its size and all threads and processes share the pages.
+// A ROOT beam profile is read into memory once, with x' = y' = p = 0.
+class BeamProfile
+{
+public:
+  using BeamEntry = BeamPhaseSpace::BeamEntry;
+
+  // Profile of the current beam configuration. It is reloaded when the beam
+  // keys changed since the last call; holders of the previous one keep it
+  // alive until they ask again.
+  static std::shared_ptr<const BeamProfile> Get();
+
+  ~BeamProfile();
+
+  std::size_t GetNumOfEntries() const { return m_nentries; }
+
+  // Entry for the given event index. Random and alias sampling use the
+  // calling thread's engine. Returns false once sequential sampling has
+  // used up every entry.
+  G4bool Sample(G4long index, BeamEntry &entry) const;
+
+private:
+  BeamProfile(const BeamConfig &beam);
+  void LoadROOT(const G4String &path);
+  void MapBinary(const G4String &path, G4int run);
+  void BuildAliasTable(G4int nbins);
+
+  BeamConfig::Sampling m_sampling;
+  const BeamEntry *m_entries;
+  std::size_t m_nentries;
+  std::vector<BeamEntry> m_owned; // entries read from ROOT
+  void *m_map;
+  std::size_t m_map_size;
+
+  // Walker alias table over a nbins x nbins histogram of (x, y). x and y
+  // are uniform in the chosen cell, x', y' and p come from one of its
+  // entries, listed in m_cell_entries[m_cell_start[c], m_cell_start[c+1]).
+  G4int m_nbins;
+  G4double m_xmin, m_ymin, m_dx, m_dy;
+  std::vector<G4double> m_alias_prob;
+  std::vector<G4int> m_alias;
+  std::vector<std::size_t> m_cell_start;
+  std::vector<std::size_t> m_cell_entries;
+};
+
+#endif
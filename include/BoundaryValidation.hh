@@ -0,0 +1,67 @@
+#ifndef BOUNDARY_VALIDATION_HH
+#define BOUNDARY_VALIDATION_HH
+
+#include <mutex>
+#include <vector>
+
+#include "G4OpBoundaryProcess.hh"
+#include "globals.hh"
+
+// Outcomes of the SACOpBoundaryProcess fast paths next to those of the stock
+// G4OpBoundaryProcess for the same photons ("optical_boundary validate").
+// Each thread fills its own Tallies, they are merged at the end of the run
+// and the master compares the reflection angle distributions with a
+// Kolmogorov-Smirnov test.
+class BoundaryValidation
+{
+public:
+  static const G4int kNBins = 200;
+
+  enum Outcome
+  {
+    Reflected,
+    Transmitted,
+    Absorbed,
+    Killed, // NoRINDEX
+    Other,
+    kNOutcomes
+  };
+
+  // surfaces with a fast path
+  enum Kind
+  {
+    FrontPainted,
+    BackPaintedNoRIndex,
+    kNKinds
+  };
+
+  struct Tally
+  {
+    G4long outcomes[kNOutcomes] = {};
+    // cos of the reflection angle to the surface normal
+    std::vector<G4long> cos_theta = std::vector<G4long>(kNBins, 0);
+
+    void Add(G4OpBoundaryProcessStatus status, G4double cos_reflection);
+    void Merge(const Tally &other);
+  };
+
+  struct Tallies
+  {
+    Tally fast[kNKinds];
+    Tally stock[kNKinds];
+  };
+
+  static BoundaryValidation &GetInstance();
+
+  void Merge(const Tallies &tallies);
+  // Print the comparison of the merged tallies and clear them
+  void Report();
+
+private:
+  BoundaryValidation() = default;
+
+  std::mutex m_mutex;
+  Tallies m_tallies;
+};
+
+#endif
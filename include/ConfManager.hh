@@ -2,22 +2,169 @@
 #define CONFMANAGER_HH
 
 #include <string>
-#include <unordered_map>
+#include <vector>
+
+// Typed view of the conf file. Filled by ConfManager::LoadConfigFile and
+// read-only during a run, so worker threads can share it without locking.
+// Lengths are in mm and momenta in GeV/c, as written in the conf file.
+struct GeneralConfig {
+    int decay = 0;
+    int nthreads = 1;
+    // QGSP_BERT or optical (EM + decay + optical only)
+    std::string physics_list = "QGSP_BERT";
+    int em_option = 4; // G4EmStandardPhysics(_optionN)
+    // directory of stored physics tables, empty = always build them
+    std::string physics_table_cache;
+    // 0: progress lines only, 1: also one line per event
+    int verbose = 0;
+    // seconds between progress lines, 0 = none
+    double progress_interval = 10.;
+    // step counts and event wall times in the output file, see Instrumentation
+    bool instrumentation = false;
+};
+
+struct BeamConfig {
+    // how beam profile entries are picked for each event
+    enum Sampling { Sequential, Cyclic, Random, Alias };
+
+    std::string particle;
+    double momentum = 0.;
+    std::string beamfile;
+    int run = -1; // run of a multi-run .bin beam file
+    Sampling sampling = Cyclic;
+    int alias_bins = 64; // per axis
+};
+
+struct GeometryConfig {
+    // boolean: one chained G4SubtractionSolid, segments: four walls with a
+    // G4MultiUnion of holes each, same volume, cheaper to navigate
+    enum FrameConstruction { FrameBoolean, FrameSegments };
+
+    double gel_size_x = 0.;
+    double gel_size_y = 0.;
+    double gel_size_z = 0.;
+    double teflon_thickness = 0.;
+    double blacksheet_thickness = 0.;
+    double frame_thickness = 0.;
+    int pmt_channel = 0;
+    double pmt_x_spacing = 0.;
+    double pmt_y_spacing = 0.;
+    double pmt_casing_radius = 0.;
+    double pmt_window_radius = 0.;
+    double pmt_thickness = 0.;
+    FrameConstruction frame_construction = FrameBoolean;
+};
+
+struct OpticsConfig {
+    // stock: G4OpBoundaryProcess everywhere, fast: SACOpBoundaryProcess fast
+    // paths on the painted gel-Teflon surfaces, validate: run both there,
+    // propagate the stock result and compare them at the end of the run
+    enum Boundary { BoundaryStock, BoundaryFast, BoundaryValidate };
+
+    int teflon_layer = 0;
+    double sigma_alpha = 0.;
+    // kill optical photons at birth with probability 1 - eff(E)/eff_max
+    bool qe_culling = false;
+    Boundary boundary = BoundaryStock;
+    // kill photons refracted into BlackSheet, Teflon or POM at the boundary
+    bool absorber_kill = false;
+    // materials emitting Cherenkov light, empty = all
+    std::vector<std::string> cerenkov_materials;
+    // Cherenkov photons are only generated in [min, max] (eV), both 0 = the
+    // whole RINDEX range; cerenkov_band_pmt = the PMT efficiency range
+    bool cerenkov_band_pmt = false;
+    double cerenkov_band_min = 0.;
+    double cerenkov_band_max = 0.;
+    // track optical photons only if the event has Cherenkov light in the
+    // aerogel, other events are written without hits
+    bool event_prefilter = false;
+    // optical photon kill policies, 0 = off
+    bool photon_kill_escape = false; // leaving SACMotherPV
+    double photon_time_gate = 0.;    // global time, ns
+    double photon_max_length = 0.;   // track length, mm
+    int photon_max_boundaries = 0;   // geometry boundaries crossed or hit
+};
+
+// How a per-hit double column is stored in the output tree. Float16 and
+// Double32 pack values in [min, max] into nbits; without a range they
+// behave as float (Double32 is then written as float).
+struct ColumnPrecision {
+    enum Type { Double, Float, Float16, Double32 };
+    Type type = Double;
+    double min = 0.;
+    double max = 0.;
+    int nbits = 0;
+};
+
+// Production cuts (mm) of the regions defined in DetectorConstruction,
+// 0 = the default cut of the physics list.
+struct CutsConfig {
+    double aerogel = 0.;
+    double pmt_window = 0.;
+    double passive = 0.; // Teflon, BlackSheet, PMT casings
+    double air = 0.;     // SACMotherPV
+};
+
+struct OutputConfig {
+    // TTree::SetAutoFlush/SetAutoSave: > 0 entries, < 0 bytes
+    long long tree_autoflush = -30000000;
+    long long tree_autosave = -300000000;
+    // fill the tree from a dedicated writer thread through a queue of
+    // output_queue_depth preallocated event records
+    bool async_output = false;
+    int output_queue_depth = 64;
+    // ROOT implicit MT pool for basket compression, 0 = off
+    int output_imt_threads = 0;
+    // file compression, empty = ROOT default
+    std::string compression;
+    int compression_level = 1;
+    int basket_size = 32000;
+    // units as in the tree: mm, ns, MeV
+    ColumnPrecision precision_pos;
+    ColumnPrecision precision_time;
+    ColumnPrecision precision_energy;
+    // wave_length is derived from energy
+    bool store_wave_length = true;
+};
+
+struct SACConfig {
+    GeneralConfig general;
+    BeamConfig beam;
+    GeometryConfig geometry;
+    OpticsConfig optics;
+    CutsConfig cuts;
+    OutputConfig output;
+};
 
 class ConfManager {
 public:
     static ConfManager& GetInstance();
-    
-    std::string Get(const std::string& key) const;
-    double GetDouble(const std::string& key) const;
-    int GetInt(const std::string& key) const;
 
-    void Set(const std::string& key, const std::string& value);
+    const SACConfig& GetConfig() const { return config; }
+
+    // Incremented whenever the configuration changes. Objects that cache
+    // configuration values compare it to refresh them.
+    unsigned GetGeneration() const { return generation; }
+
+    // Throws std::runtime_error on unreadable files, unknown or duplicated
+    // keys, malformed values and missing required keys. Replacing the
+    // configuration is only allowed between runs.
     void LoadConfigFile(const std::string& filename);
+    void SetBeamFile(const std::string& beamfile);
 
 private:
     ConfManager();
-    std::unordered_map<std::string, std::string> config_map;
+    SACConfig config;
+    unsigned generation = 0;
 };
 
+// Whether the geometry has to be rebuilt to go from a to b.
+bool GeometryDiffers(const SACConfig& a, const SACConfig& b);
+// Whether the region production cuts differ, applied without a rebuild.
+bool CutsDiffer(const SACConfig& a, const SACConfig& b);
+// Whether anything needs the per-step callback: instrumentation,
+// absorber_kill or a photon kill policy. SteppingAction is only registered
+// if so at startup.
+bool NeedsSteppingAction(const SACConfig& c);
+
 #endif // CONFMANAGER_HH
@@ -20,15 +20,18 @@ private:
   std::map<G4String, G4Element *> m_element_map;
   std::map<G4String, G4Material *> m_material_map;
   G4LogicalVolume *m_world_lv;
+  G4LogicalVolume *m_pmt_window_lv;
   G4bool m_check_overlaps;
   G4OpticalSurface *gel_steflon_surf, *gel_fteflon_surf;
 
 private:
   virtual G4VPhysicalVolume *Construct();
+  virtual void ConstructSDandField();
   void ConstructElements();
   void ConstructMaterials();
   void ConstructSAC();
   void AddOpticalProperties();
+  void ConstructOpticalSurfaces();
   void DumpMaterialProperties(G4Material *mat);
 
   void CheckOverlaps(G4bool flag) { m_check_overlaps = flag; }
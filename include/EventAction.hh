@@ -4,13 +4,20 @@
 #include "G4UserEventAction.hh"
 #include "G4Event.hh"
 
+class AnaManager;
+class StackingAction;
+
 class EventAction : public G4UserEventAction {
 public:
-    EventAction();
+    EventAction(AnaManager& anaMan, const StackingAction& stackingAction);
     virtual ~EventAction();
 
     virtual void BeginOfEventAction(const G4Event* event);
     virtual void EndOfEventAction(const G4Event* event);
+
+private:
+    AnaManager& fAnaMan;
+    const StackingAction& fStackingAction;
 };
 
 #endif
@@ -0,0 +1,111 @@
+#ifndef EVENT_RECORD_HH
+#define EVENT_RECORD_HH
+
+#include <vector>
+
+#include "globals.hh"
+
+// Everything written to the output tree for one event. The simulation fills
+// one record while the tree branches point at another one, see AnaManager
+// and AsyncTreeWriter.
+struct EventRecord
+{
+  G4int evnum = 0;
+  G4long event_seed = 0; // replays the event with --replay <run seed> <evnum>
+  G4int nhit_pmt = 0;
+  G4int cerenkov_all = 0;
+  G4int cerenkov_aerogel = 0;
+  G4int cerenkov_glass = 0;
+  G4int cerenkov_teflon = 0;
+  G4int cerenkov_pom = 0;
+  G4int cerenkov_blacksheet = 0;
+  // Cherenkov photons not generated, see SACCerenkov
+  G4int cerenkov_skipped_material = 0;
+  G4int cerenkov_skipped_band = 0;
+  // optical photons removed by each absorber, see SteppingAction
+  G4int absorbed_blacksheet = 0;
+  G4int absorbed_teflon = 0;
+  G4int absorbed_pom = 0;
+  // optical photons killed by each kill policy, see SteppingAction
+  G4int killed_escape = 0;
+  G4int killed_time_gate = 0;
+  G4int killed_max_length = 0;
+  G4int killed_max_boundaries = 0;
+  // 1: no Cherenkov light in the aerogel, optical photons were not tracked
+  G4int prefiltered = 0;
+  G4double beam_energy = 0.;
+  G4double beam_mom_x = 0.;
+  G4double beam_mom_y = 0.;
+  G4double beam_mom_z = 0.;
+  G4double beam_pos_x = 0.;
+  G4double beam_pos_y = 0.;
+  G4double beam_pos_z = 0.;
+
+  // one entry per photon reaching a PMT window
+  std::vector<G4double> pos_x;
+  std::vector<G4double> pos_y;
+  std::vector<G4double> pos_z;
+  std::vector<G4double> time;
+  std::vector<G4double> energy;
+  std::vector<G4double> wave_length;
+  std::vector<G4int> particle_id;
+  std::vector<G4int> seg;
+  std::vector<G4int> detect_flag;
+
+  // clear() keeps the capacity, records are reused event after event
+  void ClearHits()
+  {
+    pos_x.clear();
+    pos_y.clear();
+    pos_z.clear();
+    time.clear();
+    energy.clear();
+    wave_length.clear();
+    particle_id.clear();
+    seg.clear();
+    detect_flag.clear();
+  }
+
+  // Move the content of other into this record without reallocating: the
+  // scalars are copied and the hit columns are swapped.
+  void TakeFrom(EventRecord &other)
+  {
+    evnum = other.evnum;
+    event_seed = other.event_seed;
+    nhit_pmt = other.nhit_pmt;
+    cerenkov_all = other.cerenkov_all;
+    cerenkov_aerogel = other.cerenkov_aerogel;
+    cerenkov_glass = other.cerenkov_glass;
+    cerenkov_teflon = other.cerenkov_teflon;
+    cerenkov_pom = other.cerenkov_pom;
+    cerenkov_blacksheet = other.cerenkov_blacksheet;
+    cerenkov_skipped_material = other.cerenkov_skipped_material;
+    cerenkov_skipped_band = other.cerenkov_skipped_band;
+    absorbed_blacksheet = other.absorbed_blacksheet;
+    absorbed_teflon = other.absorbed_teflon;
+    absorbed_pom = other.absorbed_pom;
+    killed_escape = other.killed_escape;
+    killed_time_gate = other.killed_time_gate;
+    killed_max_length = other.killed_max_length;
+    killed_max_boundaries = other.killed_max_boundaries;
+    prefiltered = other.prefiltered;
+    beam_energy = other.beam_energy;
+    beam_mom_x = other.beam_mom_x;
+    beam_mom_y = other.beam_mom_y;
+    beam_mom_z = other.beam_mom_z;
+    beam_pos_x = other.beam_pos_x;
+    beam_pos_y = other.beam_pos_y;
+    beam_pos_z = other.beam_pos_z;
+    pos_x.swap(other.pos_x);
+    pos_y.swap(other.pos_y);
+    pos_z.swap(other.pos_z);
+    time.swap(other.time);
+    energy.swap(other.energy);
+    wave_length.swap(other.wave_length);
+    particle_id.swap(other.particle_id);
+    seg.swap(other.seg);
+    detect_flag.swap(other.detect_flag);
+  }
+};
+
+#endif
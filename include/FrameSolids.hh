@@ -0,0 +1,32 @@
+#ifndef FRAME_SOLIDS_HH
+#define FRAME_SOLIDS_HH
+
+#include <vector>
+
+#include "G4ThreeVector.hh"
+#include "globals.hh"
+
+#include "ConfManager.hh"
+
+class G4VSolid;
+
+// Solids of the Teflon frame around the aerogel, with the PMT holes.
+//   boolean:  one solid, outer box - inner box - every hole, a chain of up
+//             to 15 nested G4SubtractionSolids walked on every navigation call
+//   segments: four walls, each a box minus one G4MultiUnion of its holes
+// Both describe the same volume. Used by DetectorConstruction and by the
+// /sac/bench/frame navigation benchmark.
+namespace FrameSolids
+{
+  struct Part
+  {
+    G4String name; // of the placement, e.g. TeflonFrameTop
+    G4VSolid *solid;
+    G4ThreeVector position; // in the SAC mother volume, parts are not rotated
+  };
+
+  std::vector<Part> Build(const GeometryConfig &geom,
+                          GeometryConfig::FrameConstruction construction);
+}
+
+#endif
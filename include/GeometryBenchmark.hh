@@ -0,0 +1,18 @@
+#ifndef GEOMETRY_BENCHMARK_HH
+#define GEOMETRY_BENCHMARK_HH
+
+#include "globals.hh"
+
+// Micro-benchmarks of the geometry, run from the /sac/bench/ commands
+// between runs. They build their own test volumes and leave the detector
+// untouched.
+namespace GeometryBenchmark
+{
+  // Locate npoints random points in and around the Teflon frame and compute
+  // one step in a random direction from each, once with the boolean and once
+  // with the segmented frame of the current configuration. Prints the time
+  // per step and checks that both frames give the same volume and distances.
+  void Frame(G4int npoints);
+}
+
+#endif
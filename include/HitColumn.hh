@@ -0,0 +1,35 @@
+#ifndef HIT_COLUMN_HH
+#define HIT_COLUMN_HH
+
+#include <vector>
+
+#include "globals.hh"
+#include "ConfManager.hh"
+
+class TBranch;
+class TTree;
+
+// Writes one per-hit column of an EventRecord to the output tree with the
+// configured precision. Double columns point the branch at the record
+// directly; the reduced precisions go through a scratch buffer that
+// Stage() refills before every TTree::Fill.
+class HitColumn
+{
+public:
+  HitColumn();
+
+  // count is the name of the leaf holding the number of hits
+  void Branch(TTree *tree, const char *name, const char *count,
+              std::vector<G4double> &source, const ColumnPrecision &precision,
+              G4int basket_size);
+  void Stage();
+
+private:
+  ColumnPrecision::Type m_type;
+  std::vector<G4double> *m_source;
+  TBranch *m_branch;
+  std::vector<G4float> m_float;
+  std::vector<G4double> m_double;
+};
+
+#endif
@@ -0,0 +1,70 @@
+#ifndef INSTRUMENTATION_HH
+#define INSTRUMENTATION_HH
+
+#include <chrono>
+#include <vector>
+
+#include "globals.hh"
+
+class G4Event;
+class G4Step;
+class SACOpBoundaryProcess;
+class TFile;
+
+// Where the tracking time goes, with "instrumentation 1". Counts the steps
+// per logical volume and per particle, and the optical photon boundary steps
+// per volume entered and per boundary status. Every event gets a row in the
+// "instrumentation" tree with its wall time and totals. The rows and the
+// per-run counts, as labelled histograms, are written into the output file at
+// the end of the run, when the async writer no longer uses it. The per-thread
+// files are merged with the main tree.
+class Instrumentation
+{
+public:
+  // one per thread, like AnaManager
+  static Instrumentation &GetInstance();
+
+  G4bool IsEnabled() const { return m_enabled; }
+
+  void BeginOfRun();
+  // file: the output file of this thread
+  void EndOfRun(TFile *file);
+  void BeginOfEvent();
+  void EndOfEvent(const G4Event *event);
+  void Step(const G4Step *step);
+
+private:
+  Instrumentation();
+
+  using Clock = std::chrono::steady_clock;
+
+  struct Row
+  {
+    G4int evnum;
+    G4double wall_time; // s
+    G4long steps;
+    G4long optical_steps;
+    G4long optical_boundaries;
+  };
+
+  static void Count(std::vector<G4long> &counts, G4int index);
+  void WriteTree() const;
+  void WriteHistograms() const;
+
+  G4bool m_enabled;
+  const SACOpBoundaryProcess *m_boundary; // nullptr: no boundary statuses
+  Clock::time_point m_event_start;
+
+  // per run, indexed by G4LogicalVolume::GetInstanceID(),
+  // G4ParticleDefinition::GetParticleDefinitionID() and
+  // G4OpBoundaryProcessStatus
+  std::vector<G4long> m_steps_by_volume;
+  std::vector<G4long> m_steps_by_particle;
+  std::vector<G4long> m_boundaries_by_volume;
+  std::vector<G4long> m_boundaries_by_status;
+
+  std::vector<Row> m_rows;
+  Row m_current; // of the event being tracked
+};
+
+#endif
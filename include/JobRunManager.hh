@@ -0,0 +1,49 @@
+#ifndef JOB_RUN_MANAGER_HH
+#define JOB_RUN_MANAGER_HH
+
+#include <cstdint>
+
+#include "G4RunManager.hh"
+
+// Sequential run manager that can split every beamOn over forked jobs.
+// The parent builds geometry and physics tables first (BeamOn(0)) so the
+// children share them copy-on-write. Job j processes its own event range
+// with its own seed stream into <output>_j<j>.root, and the parent merges
+// the job files into the output path when all jobs have finished.
+class JobRunManager : public G4RunManager
+{
+public:
+  JobRunManager(G4int njobs);
+  ~JobRunManager() override;
+
+  void BeamOn(G4int n_event, const char *macroFile = nullptr, G4int n_select = -1) override;
+
+  // also used with the MT run manager, where there is a single job
+  static void SetBaseSeed(std::uint64_t seed) { fBaseSeed = seed; }
+  static std::uint64_t GetBaseSeed() { return fBaseSeed; }
+  static G4int GetJobIndex() { return fJobIndex; }
+  // added to the event ID for beam sampling and the evnum branch
+  static G4long GetEventOffset() { return fEventOffset; }
+
+  // Seed of the current run, set by the master RunAction. Every event is
+  // seeded from (run seed, event ID + offset), independent of jobs and
+  // threads.
+  static void SetRunSeed(long seed) { fRunSeed = seed; }
+  static long GetRunSeed() { return fRunSeed; }
+
+  // --replay: the next run simulates one event of the given run seed and
+  // event ID
+  static void SetReplay(long run_seed, G4long event_id);
+  static G4bool IsReplay() { return fReplay; }
+
+private:
+  G4int fNJobs;
+
+  static std::uint64_t fBaseSeed;
+  static G4int fJobIndex;
+  static G4long fEventOffset;
+  static long fRunSeed;
+  static G4bool fReplay;
+};
+
+#endif
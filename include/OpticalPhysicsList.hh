@@ -0,0 +1,31 @@
+#ifndef OPTICAL_PHYSICS_LIST_HH
+#define OPTICAL_PHYSICS_LIST_HH
+
+#include "G4OpticalPhysics.hh"
+#include "G4VModularPhysicsList.hh"
+
+// EM + optical physics without hadronics, for the beam particles and
+// momenta used here only EM showering and Cherenkov light matter.
+// Selected with "physics_list optical".
+class OpticalPhysicsList : public G4VModularPhysicsList
+{
+public:
+  // em_option 0-4 selects G4EmStandardPhysics(_optionN)
+  OpticalPhysicsList(G4int em_option, G4bool decay);
+  ~OpticalPhysicsList() override;
+};
+
+// G4OpticalPhysics with its boundary process wrapped by SACOpBoundaryProcess
+// and G4Cerenkov replaced by SACCerenkov. Used by both physics lists,
+// "optical_boundary", "cerenkov_materials" and "cerenkov_band" select what
+// they do.
+class SACOpticalPhysics : public G4OpticalPhysics
+{
+public:
+  void ConstructProcess() override;
+};
+
+// G4EmStandardPhysics for option 0, G4EmStandardPhysics_optionN otherwise
+G4VPhysicsConstructor *CreateEmPhysics(G4int em_option);
+
+#endif
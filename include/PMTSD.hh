@@ -2,13 +2,13 @@
 #define PMTSD_HH
 
 #include "G4VSensitiveDetector.hh"
-#include "PMTHit.hh"
 
-#include "TSpline.h"
+#include <vector>
 
 class G4Step;
 class G4TouchableHistory;
 class G4HCofThisEvent;
+class AnaManager;
 
 class PMTSD : public G4VSensitiveDetector
 {
@@ -16,16 +16,40 @@ public:
   PMTSD(const G4String &name);
   ~PMTSD() override;
 
-  void Initialize(G4HCofThisEvent *HCE) override;
+  void Initialize(G4HCofThisEvent *hce) override;
   G4bool ProcessHits(G4Step *step, G4TouchableHistory *history) override;
-  void EndOfEvent(G4HCofThisEvent *HCE) override;
+
+  // QE x window transmittance, linear interpolation in the baked table
+  inline G4double GetEfficiency(G4double energy) const
+  {
+    if (energy < m_eff_emin || energy > m_eff_emax)
+      return 0.;
+    const G4double x = (energy - m_eff_emin) * m_eff_inv_step;
+    std::size_t i = static_cast<std::size_t>(x);
+    if (i > m_eff_table.size() - 2)
+      i = m_eff_table.size() - 2;
+    const G4double frac = x - i;
+    return m_eff_table[i] + frac * (m_eff_table[i + 1] - m_eff_table[i]);
+  }
+  G4double GetMaxEfficiency() const { return m_eff_max; }
+  // outside [min, max] the efficiency is 0
+  G4double GetEfficiencyMinEnergy() const { return m_eff_emin; }
+  G4double GetEfficiencyMaxEnergy() const { return m_eff_emax; }
 
 private:
-  G4THitsCollection<PMTHit> *m_hits_collection;
-  TSpline3 *m_qe_spline;
-  TSpline3 *m_trans_spline;
-  G4double m_range_min;
-  G4double m_range_max;
+  // hits go straight into the per-event columns of this thread's sink
+  AnaManager &m_ana_man;
+
+  // uniform-energy table of the combined efficiency, built once from the
+  // QE and transmittance splines
+  std::vector<G4double> m_eff_table;
+  G4double m_eff_emin;
+  G4double m_eff_emax;
+  G4double m_eff_inv_step;
+  G4double m_eff_max;
+
+  // photons were already culled at birth by StackingAction
+  G4bool m_qe_culling;
 
   void InitializeQESplines();
 };
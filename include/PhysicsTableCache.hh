@@ -0,0 +1,37 @@
+#ifndef PHYSICS_TABLE_CACHE_HH
+#define PHYSICS_TABLE_CACHE_HH
+
+#include <string>
+
+#include "globals.hh"
+
+class G4RunManager;
+class G4VUserPhysicsList;
+
+// Stores the physics tables after the first initialisation and retrieves
+// them in later jobs. Each cache entry is a directory named after a hash of
+// everything the tables depend on: Geant4 version, physics list options,
+// production cuts, materials and their optical property tables. Any change
+// gives a new directory. Only the kMaxEntries most recently used entries are
+// kept, older ones are removed when a new entry is stored.
+class PhysicsTableCache
+{
+public:
+  PhysicsTableCache(const std::string &root);
+
+  // After G4RunManager::Initialize(), before the first run: retrieve the
+  // tables if this key is cached, otherwise build them now with BeamOn(0)
+  // and store them.
+  void Setup(G4RunManager *run_manager, G4VUserPhysicsList *physics_list);
+
+private:
+  static const std::size_t kMaxEntries;
+
+  G4String ComputeKey(const G4VUserPhysicsList *physics_list) const;
+  // remove the least recently used entries other than the key keep
+  void Prune(const std::string &keep) const;
+
+  std::string m_root;
+};
+
+#endif
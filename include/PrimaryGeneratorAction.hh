@@ -5,26 +5,34 @@
 #include "G4ParticleGun.hh"
 #include "G4ParticleTable.hh"
 #include "G4ThreeVector.hh"
-#include "TFile.h"
-#include "TTree.h"
+
+#include <memory>
+
+class AnaManager;
+class BeamProfile;
+class G4ParticleDefinition;
 
 class PrimaryGeneratorAction : public G4VUserPrimaryGeneratorAction
 {
 public:
-  PrimaryGeneratorAction();
+  PrimaryGeneratorAction(AnaManager &anaMan);
   ~PrimaryGeneratorAction() override;
 
   void GeneratePrimaries(G4Event *anEvent) override;
 
 private:
-  TFile *fBeamFile = nullptr;
-  TTree *fBeamTree = nullptr;
-  int fNEntries = 0;
-  int fCurrentEntry = 0;
-  double beam_x = 0.0;
-  double beam_y = 0.0;
+  AnaManager &fAnaMan;
+  std::shared_ptr<const BeamProfile> fBeamProfile;
   G4ParticleGun *fParticleGun; // Particle gun
-  void GenerateBeam(G4Event *anEvent);
+
+  // taken from the configuration when it changes, nothing is parsed per event
+  void Configure();
+  unsigned fConfGeneration = 0;
+  G4ParticleDefinition *fParticle = nullptr;
+  G4double fMomentum = 0.;   // central momentum
+  G4double fBeamZ = 0.;      // gun z position, 10 mm upstream of the black sheet
+  // eventID includes the job offset
+  void GenerateBeam(G4Event *anEvent, G4long eventID);
 };
 
 #endif
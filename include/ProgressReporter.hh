@@ -0,0 +1,50 @@
+#ifndef PROGRESS_REPORTER_HH
+#define PROGRESS_REPORTER_HH
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+#include "globals.hh"
+
+// Process-wide progress and throughput counters, and the end-of-run summary
+// used to compare physics lists. Worker threads add their
+// events with EndOfEvent(); whichever thread first passes the next print
+// time writes the progress line, so the console is written at most once
+// per interval whatever the event rate.
+class ProgressReporter
+{
+public:
+  static ProgressReporter &GetInstance();
+
+  // master thread, nevents is the beamOn argument
+  void BeginOfRun(G4int nevents, G4double interval);
+  void EndOfEvent(G4int tracked_photons, G4int detected_pe);
+  void EndOfRun();
+
+  // printed with the run summary
+  void SetStartupTime(G4double seconds) { m_startup_time = seconds; }
+  // each thread adds its per-channel photoelectrons at the end of the run
+  void MergeChannels(const std::vector<G4long> &npe_per_channel);
+
+private:
+  using Clock = std::chrono::steady_clock;
+
+  ProgressReporter();
+  void Print(G4bool final);
+
+  Clock::time_point m_start;
+  G4int m_nevents;
+  G4long m_interval_ns;
+  std::atomic<G4long> m_next_print_ns;
+  std::atomic<G4long> m_events;
+  std::atomic<G4long> m_photons;
+  std::atomic<G4long> m_pe;
+
+  G4double m_startup_time;
+  std::mutex m_channel_mutex;
+  std::vector<G4long> m_npe_per_channel;
+};
+
+#endif
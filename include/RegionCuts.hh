@@ -0,0 +1,38 @@
+#ifndef REGION_CUTS_HH
+#define REGION_CUTS_HH
+
+#include "globals.hh"
+
+#include "ConfManager.hh"
+
+class G4LogicalVolume;
+class G4Region;
+
+// Regions of the SAC volumes, each with its own production cuts from the
+// "cut_*" keys:
+//   AerogelRegion     GelLV
+//   PMTWindowRegion   PMTWindowLV
+//   PassiveRegion     Teflon sheets and frame, BlackSheets, PMT casings
+//   SACAirRegion      SACMotherLV, i.e. the air around them
+// The world keeps the default region.
+namespace RegionCuts
+{
+  enum Kind
+  {
+    kAerogel,
+    kPMTWindow,
+    kPassive,
+    kAir,
+    kNKinds
+  };
+
+  // Create the regions with the cuts of the current configuration. They
+  // outlive geometry rebuilds, deleted volumes leave their regions.
+  void Create();
+  void AddRoot(Kind kind, G4LogicalVolume *lv);
+  // Set the cuts of the existing regions, e.g. after a conf reload. The
+  // production cuts table picks them up at the next run.
+  void Apply(const CutsConfig &cuts);
+}
+
+#endif
@@ -3,13 +3,20 @@
 
 #include "G4UserRunAction.hh"
 #include "G4Run.hh"
+#include "G4Timer.hh"
+
+class AnaManager;
 
 class RunAction : public G4UserRunAction {
 public:
-  RunAction();
+  RunAction(AnaManager& anaMan);
   virtual ~RunAction();
   virtual void BeginOfRunAction(const G4Run* aRun);
   virtual void EndOfRunAction(const G4Run* aRun);
+
+private:
+  AnaManager& fAnaMan;
+  G4Timer fTimer;
 };
 
 #endif
@@ -0,0 +1,68 @@
+#ifndef SAC_CERENKOV_HH
+#define SAC_CERENKOV_HH
+
+#include <vector>
+
+#include "G4Cerenkov.hh"
+
+class G4Material;
+
+// G4Cerenkov restricted by "cerenkov_materials" and "cerenkov_band":
+//  - in materials that do not emit, no photon is generated and the step is
+//    not limited by Cherenkov
+//  - with a band, photons are only generated in [min, max] and their number
+//    is the integral of the Cherenkov spectrum over the band, the energies
+//    are sampled as in G4Cerenkov
+// The photons that G4Cerenkov would have generated in addition are only
+// counted: a Poisson of the missing mean number, independent of the
+// generated ones.
+class SACCerenkov : public G4Cerenkov
+{
+public:
+  SACCerenkov();
+  ~SACCerenkov() override;
+
+  void BuildPhysicsTable(const G4ParticleDefinition &particle) override;
+  void StartTracking(G4Track *track) override;
+  G4double PostStepGetPhysicalInteractionLength(const G4Track &track, G4double previous_step_size,
+                                                G4ForceCondition *condition) override;
+  G4VParticleChange *PostStepDoIt(const G4Track &track, const G4Step &step) override;
+
+  // the Cherenkov process of this thread, nullptr if it is the stock one
+  static SACCerenkov *GetForThisThread();
+
+  // photons not generated in the current event
+  G4int GetNumOfSkippedMaterial() const { return m_skipped_material; }
+  G4int GetNumOfSkippedBand() const { return m_skipped_band; }
+  void ResetCounters();
+
+private:
+  // cumulative integral of 1/n^2 over the RINDEX energies, as G4Cerenkov's
+  // angle integrals
+  struct AngleIntegral
+  {
+    std::vector<G4double> energy;
+    std::vector<G4double> value;
+    G4double Value(G4double e) const;
+  };
+
+  void Refresh();
+  G4bool Emits(const G4Material *material) const;
+  G4double BandPhotonsPerLength(G4double charge, G4double beta, G4MaterialPropertyVector *rindex,
+                                const AngleIntegral &integral) const;
+  G4VParticleChange *BandPostStepDoIt(const G4Track &track, const G4Step &step,
+                                      G4MaterialPropertyVector *rindex);
+
+  unsigned m_generation;
+  std::vector<char> m_emits;                // by G4Material::GetIndex()
+  std::vector<AngleIntegral> m_integrals;   // by G4Material::GetIndex()
+  G4bool m_band;
+  G4double m_band_min;
+  G4double m_band_max;
+  G4int m_secondary_id;
+
+  G4int m_skipped_material;
+  G4int m_skipped_band;
+};
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef SAC_MESSENGER_HH
+#define SAC_MESSENGER_HH
+
+#include "G4UImessenger.hh"
+#include "globals.hh"
+
+class G4UIdirectory;
+class G4UIcmdWithAString;
+class G4UIcmdWithAnInteger;
+
+// Commands to run several configurations in one process between runs:
+//   /sac/conf/load <file>   replace the configuration, the geometry is
+//                           rebuilt only if geometry or surface keys changed
+//   /sac/output <path>      output rootfile of the next run
+//   /sac/beamfile <file>    beam file of the next run
+//   /sac/bench/frame <n>    boolean vs segmented frame navigation benchmark
+// They act on process-wide state and are not broadcast to worker threads.
+class SACMessenger : public G4UImessenger
+{
+public:
+  SACMessenger();
+  ~SACMessenger() override;
+
+  void SetNewValue(G4UIcommand *command, G4String value) override;
+
+private:
+  void LoadConfig(G4UIcommand *command, const G4String &filename);
+
+  G4UIdirectory *m_sac_dir;
+  G4UIdirectory *m_conf_dir;
+  G4UIcmdWithAString *m_load_cmd;
+  G4UIcmdWithAString *m_output_cmd;
+  G4UIcmdWithAString *m_beamfile_cmd;
+  G4UIdirectory *m_bench_dir;
+  G4UIcmdWithAnInteger *m_bench_frame_cmd;
+  // whether SteppingAction was registered at startup
+  G4bool m_stepping_action;
+};
+
+#endif
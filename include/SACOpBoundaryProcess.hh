@@ -0,0 +1,88 @@
+#ifndef SAC_OP_BOUNDARY_PROCESS_HH
+#define SAC_OP_BOUNDARY_PROCESS_HH
+
+#include <vector>
+
+#include "G4OpBoundaryProcess.hh"
+#include "G4WrapperProcess.hh"
+
+#include "BoundaryValidation.hh"
+#include "ConfManager.hh"
+
+class G4VPhysicalVolume;
+
+// Wraps the stock G4OpBoundaryProcess and handles the painted gel-Teflon
+// border surfaces itself:
+//   unified, front painted:  reflectivity/transmittance lookup and a
+//                            Lambertian (ground) or specular (polished)
+//                            reflection; the Lambertian direction is drawn
+//                            from its inverse CDF, cos = sqrt(u), instead of
+//                            G4LambertianRand's rejection loop
+//   unified, back painted,   killed as NoRINDEX, like the stock process
+//   no RINDEX on the surface
+// The surface of each (pre, post) volume pair is resolved once into a flat
+// table indexed by volume instance IDs. Every other boundary, and any
+// unusual step, is passed to the stock process. Installed by
+// SACOpticalPhysics, the mode comes from "optical_boundary".
+class SACOpBoundaryProcess : public G4WrapperProcess
+{
+public:
+  // takes ownership of stock
+  explicit SACOpBoundaryProcess(G4OpBoundaryProcess *stock);
+  ~SACOpBoundaryProcess() override;
+
+  void StartTracking(G4Track *track) override;
+  G4VParticleChange *PostStepDoIt(const G4Track &track, const G4Step &step) override;
+
+  // of the last step, from whichever process handled it
+  G4OpBoundaryProcessStatus GetStatus() const;
+
+  // The boundary process of the optical photons of this thread, nullptr if
+  // the stock one is installed
+  static SACOpBoundaryProcess *GetForThisThread();
+  // Add this thread's validation tallies to BoundaryValidation, reset them
+  void FlushValidation();
+
+private:
+  struct Surface
+  {
+    enum Kind : unsigned char
+    {
+      Unresolved,
+      Stock,
+      FrontPainted,
+      BackPaintedNoRIndex
+    };
+    Kind kind = Unresolved;
+    G4bool lambertian = false;                         // ground, else polished
+    G4MaterialPropertyVector *reflectivity = nullptr;  // nullptr = 1
+    G4MaterialPropertyVector *transmittance = nullptr; // nullptr = 0
+    G4MaterialPropertyVector *groupvel = nullptr;      // of the next volume
+  };
+
+  void Refresh();
+  const Surface &Find(const G4VPhysicalVolume *pre, const G4VPhysicalVolume *post);
+  static Surface Resolve(const G4VPhysicalVolume *pre, const G4VPhysicalVolume *post);
+  G4VParticleChange *FastPostStepDoIt(const G4Track &track, const Surface &surface,
+                                      const G4ThreeVector &normal);
+  G4bool SurfaceNormal(const G4ThreeVector &position, const G4ThreeVector &direction,
+                       G4ThreeVector &normal) const;
+
+  G4OpBoundaryProcess *m_stock;
+  OpticsConfig::Boundary m_mode;
+  unsigned m_generation;
+  G4int m_world_id;
+  G4double m_tolerance;
+
+  // m_nvolumes x m_nvolumes, by instance ID - m_first_id
+  std::vector<Surface> m_surfaces;
+  G4int m_first_id;
+  G4int m_nvolumes;
+  Surface m_stock_surface;
+
+  G4OpBoundaryProcessStatus m_status;
+  G4bool m_fast_last;
+  BoundaryValidation::Tallies m_tallies;
+};
+
+#endif
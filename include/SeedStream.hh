@@ -0,0 +1,27 @@
+#ifndef SEED_STREAM_HH
+#define SEED_STREAM_HH
+
+#include <cstdint>
+
+// Deterministic, independent seeds derived from one base seed with the
+// splitmix64 finaliser, e.g. Derive(base, job, run). Nothing depends on the
+// wall clock, so a run is reproduced by its base seed.
+namespace SeedStream
+{
+  inline std::uint64_t SplitMix64(std::uint64_t x)
+  {
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+  }
+
+  // positive, fits the long taken by G4Random::setTheSeed
+  inline long Derive(std::uint64_t base, std::uint64_t a, std::uint64_t b)
+  {
+    const std::uint64_t seed = SplitMix64(SplitMix64(SplitMix64(base) ^ a) ^ b);
+    return static_cast<long>(seed >> 33);
+  }
+}
+
+#endif
@@ -4,12 +4,18 @@
 #include "globals.hh"
 #include "G4UserStackingAction.hh"
 
+#include <vector>
+
 class G4HCofThisEvent;
+class G4VPhysicalVolume;
+class AnaManager;
+class PMTSD;
+class SACCerenkov;
 
 class StackingAction : public G4UserStackingAction
 {
 public:
-  StackingAction();
+  StackingAction(AnaManager &anaMan);
   virtual ~StackingAction();
 
 public:
@@ -17,10 +23,39 @@ public:
   virtual void NewStage();
   virtual void PrepareNewEvent();
 
+  // optical photons pushed to the stack in the current event
+  G4int GetNumOfTrackedPhotons() const { return fTrackedPhotons; }
+
 private:
+  void BeginOfRun();
+  G4int CerenkovInMaterial(G4int index) const;
+
+  AnaManager &fAnaMan;
   G4int fScintillationAll;
   G4int fCerenkovAll;
   G4int fCerenkovAerogel;
+  G4int fTrackedPhotons;
+
+  // resolved at the first event of each run, compared by pointer/index
+  G4int fRunID;
+  const G4VPhysicalVolume *fGelPV;
+  std::vector<G4int> fCerenkovByMaterial; // indexed by G4Material::GetIndex()
+  G4int fGlassIndex;
+  G4int fTeflonIndex;
+  G4int fPOMIndex;
+  G4int fBlackSheetIndex;
+
+  // optical photons wait until the first stage is over, and are dropped if
+  // it made no Cherenkov light in the aerogel
+  G4bool fPrefilter;
+  G4int fStage;
+
+  // QE-biased culling of optical photons at birth
+  G4bool fQECulling;
+  const PMTSD *fPMTSD;
+
+  // nullptr with the stock G4Cerenkov
+  SACCerenkov *fSACCerenkov;
 };
 
 #endif
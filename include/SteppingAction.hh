@@ -4,16 +4,71 @@
 #include "G4UserSteppingAction.hh"
 #include "globals.hh"
 
+#include <vector>
+
 class G4Step;
+class G4StepPoint;
 class G4Track;
+class G4Material;
+class AnaManager;
+class Instrumentation;
+class SACOpBoundaryProcess;
 
+// Optical photons entering BlackSheet, Teflon or POM are absorbed within a
+// micrometre. With "absorber_kill 1" they are killed at the boundary instead,
+// after the boundary process has decided they enter, so Fresnel reflections
+// are kept. Photons removed by each absorber are counted in both modes, as
+// long as the action is registered, see NeedsSteppingAction.
+// Alive photons are also killed, and counted per policy, when they leave
+// SACMotherPV or exceed the time gate, the track length or the number of
+// boundary steps set in the conf file.
+// With "instrumentation 1" every step of every particle is also passed to
+// Instrumentation.
 class SteppingAction : public G4UserSteppingAction
 {
 public:
-  SteppingAction();
+  SteppingAction(AnaManager &anaMan);
   virtual ~SteppingAction();
 
-  virtual void UserSteppingAction(const G4Step* step);
+  virtual void UserSteppingAction(const G4Step *step);
+
+  enum Absorber
+  {
+    kNoAbsorber = -1,
+    kBlackSheet,
+    kTeflon,
+    kPOM
+  };
+
+  enum KillPolicy
+  {
+    kNoKill = -1,
+    kKillEscape,
+    kKillTimeGate,
+    kKillMaxLength,
+    kKillMaxBoundaries
+  };
+
+private:
+  void Refresh();
+  G4int AbsorberOf(const G4Material *material) const;
+  G4int KillPolicyFor(const G4Track *track, const G4StepPoint *post) const;
+
+  AnaManager &fAnaMan;
+  Instrumentation &fInstrumentation;
+
+  // refreshed when the configuration changes
+  unsigned fGeneration;
+  G4bool fAbsorberKill;
+  const SACOpBoundaryProcess *fBoundary;
+  std::vector<G4int> fAbsorberOfMaterial; // indexed by G4Material::GetIndex()
+  G4bool fKillEscape;
+  G4double fTimeGate;     // 0 = off
+  G4double fMaxLength;    // 0 = off
+  G4int fMaxBoundaries;   // 0 = off
+
+  // boundary steps of the current track
+  G4int fBoundaries;
 };
 
 #endif
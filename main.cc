@@ -1,20 +1,29 @@
 #include "DetectorConstruction.hh"
 #include "ActionInitialization.hh"
 #include "AnaManager.hh"
+#include "JobRunManager.hh"
 #include "RunAction.hh"
+#include "SACMessenger.hh"
 #include "ConfManager.hh"
 #include "FTFP_BERT.hh"
 #include "QGSP_BERT.hh"
-#include "G4EmStandardPhysics_option4.hh"
 #include "G4OpticalPhysics.hh"
 #include "G4RunManager.hh"
+#include "G4RunManagerFactory.hh"
 #include "G4Types.hh"
 #include "G4UIExecutive.hh"
 #include "G4UImanager.hh"
 #include "G4VisExecutive.hh"
 #include "G4Cerenkov.hh"
 #include "G4DecayPhysics.hh"
+#include "G4Timer.hh"
+#include "OpticalPhysicsList.hh"
+#include "PhysicsTableCache.hh"
+#include "ProgressReporter.hh"
+#include "TROOT.h"
 #include <random>
+#include <string>
+#include <vector>
 
 namespace
 {
@@ -23,46 +32,149 @@ namespace
   void PrintUsage()
   {
     G4cerr << " Usage: " << G4endl
-           << " KVCOpticalSim <conf file> <output rootfile name> [macro]"
-           << G4endl;
+           << " KVCOpticalSim [--jobs N] [--seed S] <conf file> <output rootfile name> [macro]"
+           << G4endl
+           << "   --jobs N  fork N processes per beamOn and merge their output" << G4endl
+           << "   --seed S  base seed of all random streams (default: random)" << G4endl
+           << "   --replay <run seed> <evnum>  simulate only that event, with tracking verbose" << G4endl;
   }
 } // namespace
 
 int main(int argc, char **argv)
 {
-  if (argc < 3 || argc > 4)
+  G4int njobs = 1;
+  G4bool seed_given = false;
+  unsigned long long seed = 0;
+  G4bool replay = false;
+  long replay_seed = 0;
+  G4long replay_event = 0;
+  std::vector<std::string> args;
+  for (G4int i = 1; i < argc; ++i)
+  {
+    const std::string arg = argv[i];
+    if (arg == "--replay" && i + 2 < argc)
+    {
+      try
+      {
+        replay_seed = std::stol(argv[++i]);
+        replay_event = std::stol(argv[++i]);
+      }
+      catch (const std::exception &)
+      {
+        PrintUsage();
+        return 1;
+      }
+      replay = true;
+    }
+    else if ((arg == "--jobs" || arg == "--seed") && i + 1 < argc)
+    {
+      try
+      {
+        if (arg == "--jobs")
+          njobs = std::stoi(argv[++i]);
+        else
+          seed = std::stoull(argv[++i]);
+      }
+      catch (const std::exception &)
+      {
+        PrintUsage();
+        return 1;
+      }
+      seed_given = seed_given || arg == "--seed";
+    }
+    else
+    {
+      args.push_back(arg);
+    }
+  }
+  if (args.size() < 2 || args.size() > 3 || njobs < 1 || (replay && njobs > 1))
   {
     PrintUsage();
     return 1;
   }
-  gConfMan.LoadConfigFile(argv[1]);
-  gAnaMan.SetOutputRootfilePath(argv[2]);
+  try
+  {
+    gConfMan.LoadConfigFile(args[0]);
+  }
+  catch (const std::exception &e)
+  {
+    G4cerr << e.what() << G4endl;
+    return 1;
+  }
+  const auto &conf = gConfMan.GetConfig();
+  gAnaMan.SetOutputRootfilePath(args[1]);
 
   G4String macro;
-  if (argc == 4)
-    macro = argv[3];
+  if (args.size() == 3)
+    macro = args[2];
+
+  if (njobs > 1 && (conf.general.nthreads > 1 || conf.output.output_imt_threads > 0))
+  {
+    G4cerr << "Error: --jobs needs nthreads 1 and output_imt_threads 0" << G4endl;
+    return 1;
+  }
+
+  // every random stream of the job derives from this seed, see RunAction
+  if (!seed_given)
+  {
+    std::random_device rd;
+    seed = (static_cast<unsigned long long>(rd()) << 32) | rd();
+  }
+  JobRunManager::SetBaseSeed(seed);
+  G4cout << "   Base seed = " << seed << G4endl;
 
   G4UIExecutive *ui = nullptr;
-  if (macro.empty())
+  if (macro.empty() && !replay)
   {
     ui = new G4UIExecutive(argc, argv);
   }
 
-  auto runManager = new G4RunManager();
+  G4Timer startupTimer;
+  startupTimer.Start();
 
-  std::random_device rd;
-  G4Random::setTheSeed(rd());
+  // nthreads > 1 selects the MT/tasking run manager; every worker writes
+  // its own file and the master merges them into the output path
+  const G4int nthreads = conf.general.nthreads;
+  if (nthreads > 1 || conf.output.async_output)
+  {
+    ROOT::EnableThreadSafety();
+  }
+  if (conf.output.output_imt_threads > 0)
+  {
+    ROOT::EnableImplicitMT(conf.output.output_imt_threads);
+  }
+
+  // a replayed event runs sequentially
+  G4RunManager *runManager = nullptr;
+  if (nthreads > 1 && !replay)
+  {
+    runManager = G4RunManagerFactory::CreateRunManager(G4RunManagerType::Default);
+    runManager->SetNumberOfThreads(nthreads);
+  }
+  else
+  {
+    runManager = new JobRunManager(njobs);
+  }
 
   runManager->SetUserInitialization(new DetectorConstruction());
 
   // Physics List setting
-  // G4VModularPhysicsList* physicsList = new FTFP_BERT;
-  G4VModularPhysicsList *physicsList = new QGSP_BERT;
-  physicsList->ReplacePhysics(new G4EmStandardPhysics_option4());
-  auto opticalPhysics = new G4OpticalPhysics();
-  physicsList->RegisterPhysics(opticalPhysics);
-  if (gConfMan.GetInt("decay") == 1)
-    physicsList->RegisterPhysics(new G4DecayPhysics());
+  // "optical" drops the hadronic physics, only EM, decay and optical
+  G4VModularPhysicsList *physicsList = nullptr;
+  if (conf.general.physics_list == "optical")
+  {
+    physicsList = new OpticalPhysicsList(conf.general.em_option, conf.general.decay == 1);
+  }
+  else
+  {
+    // G4VModularPhysicsList* physicsList = new FTFP_BERT;
+    physicsList = new QGSP_BERT;
+    physicsList->ReplacePhysics(CreateEmPhysics(conf.general.em_option));
+    auto opticalPhysics = new SACOpticalPhysics();
+    physicsList->RegisterPhysics(opticalPhysics);
+    if (conf.general.decay == 1)
+      physicsList->RegisterPhysics(new G4DecayPhysics());
+  }
   runManager->SetUserInitialization(physicsList);
 
   // G4Cerenkov setting
@@ -76,6 +188,30 @@ int main(int argc, char **argv)
 
   runManager->SetUserInitialization(new ActionInitialization());
   runManager->Initialize();
+  if (!conf.general.physics_table_cache.empty())
+  {
+    PhysicsTableCache(conf.general.physics_table_cache).Setup(runManager, physicsList);
+  }
+  // the physics tables are built (or retrieved) at the first BeamOn, count
+  // them in the startup time with or without the cache
+  runManager->BeamOn(0);
+  startupTimer.Stop();
+  G4cout << "   Startup time = " << startupTimer.GetRealElapsed() << " s ("
+         << conf.general.physics_list << ")" << G4endl;
+  ProgressReporter::GetInstance().SetStartupTime(startupTimer.GetRealElapsed());
+
+  if (replay)
+  {
+    G4cout << "   Replaying event " << replay_event << " of run seed " << replay_seed << G4endl;
+    JobRunManager::SetReplay(replay_seed, replay_event);
+    G4UImanager::GetUIpointer()->ApplyCommand("/tracking/verbose 1");
+    runManager->BeamOn(1);
+    delete runManager;
+    return 0;
+  }
+
+  // /sac/ commands to scan configurations within this process
+  auto sacMessenger = new SACMessenger();
 
   G4VisManager *visManager = new G4VisExecutive("Quiet");
   visManager->Initialize();
@@ -96,6 +232,7 @@ int main(int argc, char **argv)
     delete ui;
   }
 
+  delete sacMessenger;
   delete visManager;
   delete runManager;
 
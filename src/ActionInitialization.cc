@@ -1,6 +1,8 @@
 // -*- C++ -*-
 
 #include "ActionInitialization.hh"
+#include "AnaManager.hh"
+#include "ConfManager.hh"
 #include "PrimaryGeneratorAction.hh"
 #include "RunAction.hh"
 #include "EventAction.hh"
@@ -20,16 +22,21 @@ ActionInitialization::~ActionInitialization()
 void
 ActionInitialization::BuildForMaster() const
 {
-  SetUserAction(new RunAction);
+  SetUserAction(new RunAction(AnaManager::GetInstance()));
 }
 
 //_____________________________________________________________________________
 void
 ActionInitialization::Build() const
 {
-  SetUserAction(new PrimaryGeneratorAction);
-  SetUserAction(new RunAction);
-  SetUserAction(new EventAction);
-  SetUserAction(new SteppingAction);
-  SetUserAction(new StackingAction);
+  // called once per worker thread: every worker gets its own analysis sink
+  auto &anaMan = AnaManager::GetInstance();
+  SetUserAction(new PrimaryGeneratorAction(anaMan));
+  SetUserAction(new RunAction(anaMan));
+  auto *stackingAction = new StackingAction(anaMan);
+  SetUserAction(new EventAction(anaMan, *stackingAction));
+  // no per-step callback unless something uses it
+  if (NeedsSteppingAction(ConfManager::GetInstance().GetConfig()))
+    SetUserAction(new SteppingAction(anaMan));
+  SetUserAction(stackingAction);
 }
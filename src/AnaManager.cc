@@ -1,17 +1,24 @@
 #include "AnaManager.hh"
 #include "ConfManager.hh"
+#include "Instrumentation.hh"
+#include "JobRunManager.hh"
+#include "SteppingAction.hh"
 #include "G4Run.hh"
 #include "G4Event.hh"
-#include "G4SDManager.hh"
-
-#include "PMTHit.hh"
+#include "G4RunManager.hh"
+#include "G4Threading.hh"
 
 #include "Randomize.hh"
+#include "Compression.h"
 #include "TFile.h"
+#include "TFileMerger.h"
+#include "TSystem.h"
 #include "TTree.h"
 #include "TString.h"
 #include "TMath.h"
+#include "TParameter.h"
 
+#include <algorithm>
 #include <string>
 #include <sstream>
 #include <vector>
@@ -21,27 +28,48 @@
 extern int gCerenkovCounter;
 extern double decay_check;
 
+G4String AnaManager::m_output_rootfile_path = "test.root";
+
+namespace
+{
+  // ConfManager::ToCompression only accepts these four names
+  ROOT::RCompressionSetting::EAlgorithm::EValues CompressionAlgorithm(const std::string &name)
+  {
+    if (name == "lzma")
+      return ROOT::RCompressionSetting::EAlgorithm::kLZMA;
+    if (name == "lz4")
+      return ROOT::RCompressionSetting::EAlgorithm::kLZ4;
+    if (name == "zstd")
+      return ROOT::RCompressionSetting::EAlgorithm::kZSTD;
+    return ROOT::RCompressionSetting::EAlgorithm::kZLIB;
+  }
+
+  G4int FileCompression()
+  {
+    const auto &output = ConfManager::GetInstance().GetConfig().output;
+    if (output.compression.empty())
+      return ROOT::RCompressionSetting::EDefaults::kUseCompiledDefault;
+    return ROOT::CompressionSettings(CompressionAlgorithm(output.compression),
+                                     output.compression_level);
+  }
+}
+
+// One instance per thread: each worker fills its own tree and the master
+// merges the per-worker files at the end of the run.
 AnaManager &AnaManager::GetInstance()
 {
-  static AnaManager instance;
-  return instance;
+  static G4ThreadLocal AnaManager *instance = nullptr;
+  if (!instance)
+    instance = new AnaManager;
+  return *instance;
 }
 
 AnaManager::AnaManager()
     : m_file(),
-      m_output_rootfile_path("test.root"),
-      m_tree(new TTree("tree", "GEANT4 optical simulation for SAC")),
-      m_evnum(0),
-      m_nhit_pmt(0),
-      m_cerenkov_all(0),
-      m_cerenkov_aerogel(0),
-      m_beam_energy(0.),
-      m_beam_mom_x(0.),
-      m_beam_mom_y(0.),
-      m_beam_mom_z(0.),
-      m_beam_pos_x(0.),
-      m_beam_pos_y(0.),
-      m_beam_pos_z(0.)
+      m_tree(nullptr),
+      m_current(&m_tree_record),
+      m_store_wave_length(false),
+      m_verbose(0)
 {
 }
 
@@ -52,144 +80,371 @@ AnaManager::~AnaManager()
 //_____________________________________________________________________________
 void AnaManager::BeginOfRunAction(const G4Run *)
 {
-  m_file = new TFile(m_output_rootfile_path, "RECREATE");
-  m_tree->Reset();
+  if (IsMergeMaster())
+    return;
 
-  m_tree->Branch("evnum", &m_evnum, "evnum/I");
-  m_tree->Branch("cerenkov_all", &m_cerenkov_all, "cerenkov_all/I");
-  m_tree->Branch("cerenkov_aerogel", &m_cerenkov_aerogel, "cerenkov_aerogel/I");
+  G4String path = m_output_rootfile_path;
+  if (G4Threading::IsWorkerThread())
+    path = GetPartFilePath("t" + std::to_string(G4Threading::G4GetThreadId()));
+
+  // The tree is created inside the file so that baskets are streamed to
+  // disk as they fill, and AutoSave keeps a readable header on disk.
+  const auto &output = ConfManager::GetInstance().GetConfig().output;
+  m_verbose = ConfManager::GetInstance().GetConfig().general.verbose;
+  m_npe_per_channel.clear();
+  Instrumentation::GetInstance().BeginOfRun();
+  m_file = new TFile(path.c_str(), "RECREATE", "", FileCompression());
+  m_file->cd();
+  m_tree = new TTree("tree", "GEANT4 optical simulation for SAC");
+  m_tree->SetAutoFlush(output.tree_autoflush);
+  m_tree->SetAutoSave(output.tree_autosave);
+  m_tree->GetUserInfo()->Add(new TParameter<Long64_t>("run_seed", JobRunManager::GetRunSeed()));
+  m_tree->GetUserInfo()->Add(new TParameter<Long64_t>("base_seed", JobRunManager::GetBaseSeed()));
+
+  const G4int basket = output.basket_size;
+  EventRecord &r = m_tree_record;
+  m_tree->Branch("evnum", &r.evnum, "evnum/I", basket);
+  m_tree->Branch("event_seed", &r.event_seed, "event_seed/L", basket);
+  m_tree->Branch("cerenkov_all", &r.cerenkov_all, "cerenkov_all/I", basket);
+  m_tree->Branch("cerenkov_aerogel", &r.cerenkov_aerogel, "cerenkov_aerogel/I", basket);
+  m_tree->Branch("cerenkov_glass", &r.cerenkov_glass, "cerenkov_glass/I", basket);
+  m_tree->Branch("cerenkov_teflon", &r.cerenkov_teflon, "cerenkov_teflon/I", basket);
+  m_tree->Branch("cerenkov_pom", &r.cerenkov_pom, "cerenkov_pom/I", basket);
+  m_tree->Branch("cerenkov_blacksheet", &r.cerenkov_blacksheet, "cerenkov_blacksheet/I", basket);
+  m_tree->Branch("cerenkov_skipped_material", &r.cerenkov_skipped_material, "cerenkov_skipped_material/I", basket);
+  m_tree->Branch("cerenkov_skipped_band", &r.cerenkov_skipped_band, "cerenkov_skipped_band/I", basket);
+  m_tree->Branch("absorbed_blacksheet", &r.absorbed_blacksheet, "absorbed_blacksheet/I", basket);
+  m_tree->Branch("absorbed_teflon", &r.absorbed_teflon, "absorbed_teflon/I", basket);
+  m_tree->Branch("absorbed_pom", &r.absorbed_pom, "absorbed_pom/I", basket);
+  m_tree->Branch("killed_escape", &r.killed_escape, "killed_escape/I", basket);
+  m_tree->Branch("killed_time_gate", &r.killed_time_gate, "killed_time_gate/I", basket);
+  m_tree->Branch("killed_max_length", &r.killed_max_length, "killed_max_length/I", basket);
+  m_tree->Branch("killed_max_boundaries", &r.killed_max_boundaries, "killed_max_boundaries/I", basket);
+  m_tree->Branch("prefiltered", &r.prefiltered, "prefiltered/I", basket);
 
   // -- beam -----
-  m_tree->Branch("beam_energy", &m_beam_energy, "beam_energy/D");
-  m_tree->Branch("beam_mom_x", &m_beam_mom_x, "beam_mom_x/D");
-  m_tree->Branch("beam_mom_y", &m_beam_mom_y, "beam_mom_y/D");
-  m_tree->Branch("beam_mom_z", &m_beam_mom_z, "beam_mom_z/D");
-  m_tree->Branch("beam_pos_x", &m_beam_pos_x, "beam_pos_x/D");
-  m_tree->Branch("beam_pos_y", &m_beam_pos_y, "beam_pos_y/D");
-  m_tree->Branch("beam_pos_z", &m_beam_pos_z, "beam_pos_z/D");
+  m_tree->Branch("beam_energy", &r.beam_energy, "beam_energy/D", basket);
+  m_tree->Branch("beam_mom_x", &r.beam_mom_x, "beam_mom_x/D", basket);
+  m_tree->Branch("beam_mom_y", &r.beam_mom_y, "beam_mom_y/D", basket);
+  m_tree->Branch("beam_mom_z", &r.beam_mom_z, "beam_mom_z/D", basket);
+  m_tree->Branch("beam_pos_x", &r.beam_pos_x, "beam_pos_x/D", basket);
+  m_tree->Branch("beam_pos_y", &r.beam_pos_y, "beam_pos_y/D", basket);
+  m_tree->Branch("beam_pos_z", &r.beam_pos_z, "beam_pos_z/D", basket);
 
   // -- PMT -----
-  m_tree->Branch("nhit_pmt", &m_nhit_pmt, "nhit_pmt/I");
-  m_tree->Branch("pos_x", &m_pos_x);
-  m_tree->Branch("pos_y", &m_pos_y);
-  m_tree->Branch("pos_z", &m_pos_z);
-  m_tree->Branch("time", &m_time);
-  m_tree->Branch("energy", &m_energy);
-  m_tree->Branch("wave_length", &m_wave_length);
-  m_tree->Branch("particle_id", &m_particle_id);
-  m_tree->Branch("seg", &m_seg);
-  m_tree->Branch("detect_flag", &m_detect_flag);
+  m_tree->Branch("nhit_pmt", &r.nhit_pmt, "nhit_pmt/I", basket);
+  m_store_wave_length = output.store_wave_length;
+  m_hit_columns.assign(m_store_wave_length ? 6 : 5, HitColumn());
+  m_hit_columns[0].Branch(m_tree, "pos_x", "nhit_pmt", r.pos_x, output.precision_pos, basket);
+  m_hit_columns[1].Branch(m_tree, "pos_y", "nhit_pmt", r.pos_y, output.precision_pos, basket);
+  m_hit_columns[2].Branch(m_tree, "pos_z", "nhit_pmt", r.pos_z, output.precision_pos, basket);
+  m_hit_columns[3].Branch(m_tree, "time", "nhit_pmt", r.time, output.precision_time, basket);
+  m_hit_columns[4].Branch(m_tree, "energy", "nhit_pmt", r.energy, output.precision_energy, basket);
+  if (m_store_wave_length)
+    m_hit_columns[5].Branch(m_tree, "wave_length", "nhit_pmt", r.wave_length, output.precision_energy, basket);
+  m_tree->Branch("particle_id", &r.particle_id, basket);
+  m_tree->Branch("seg", &r.seg, basket);
+  m_tree->Branch("detect_flag", &r.detect_flag, basket);
+
+  // From here on the writer thread owns m_file and m_tree until
+  // EndOfRunAction stops it.
+  if (output.async_output)
+  {
+    m_writer.reset(new AsyncTreeWriter(m_tree_record, [this]
+                                       { FillTree(); },
+                                       output.output_queue_depth));
+    m_current = m_writer->Acquire();
+  }
+  else
+  {
+    m_current = &m_tree_record;
+  }
 }
 
 void AnaManager::BeginOfEventAction(const G4Event *anEvent)
 {
+  // clear() keeps the capacity, the columns are reused event after event
+  ResetContainer();
 }
 
 void AnaManager::EndOfEventAction(const G4Event *anEvent)
 {
-  G4HCofThisEvent *HCTE = anEvent->GetHCofThisEvent();
-  if (!HCTE)
+  if (anEvent->IsAborted())
     return;
-  G4SDManager *SDMan = G4SDManager::GetSDMpointer();
 
-  m_nhit_pmt = 0;
-  G4THitsCollection<PMTHit> *PMTHC;
-  G4int ColIdPMT = SDMan->GetCollectionID("PmtCollection");
-  if (ColIdPMT >= 0)
+  m_current->nhit_pmt = static_cast<G4int>(m_current->seg.size());
+  for (G4int i = 0; i < m_current->nhit_pmt; ++i)
   {
-    PMTHC = dynamic_cast<G4THitsCollection<PMTHit> *>(HCTE->GetHC(ColIdPMT));
-    if (PMTHC)
-    {
-      m_nhit_pmt = PMTHC->entries();
-    }
+    const G4int seg = m_current->seg[i];
+    if (m_current->detect_flag[i] != 1 || seg < 0)
+      continue;
+    if (seg >= static_cast<G4int>(m_npe_per_channel.size()))
+      m_npe_per_channel.resize(seg + 1, 0);
+    ++m_npe_per_channel[seg];
   }
+  m_current->evnum = anEvent->GetEventID() + JobRunManager::GetEventOffset();
+  if (m_verbose > 0)
+    G4cout << m_current->evnum << ", " << m_current->nhit_pmt << G4endl;
 
-  ResetContainer();
-  for (int i = 0; i < m_nhit_pmt; i++)
+  if (m_writer)
+  {
+    // the beam of the next event is set before BeginOfEventAction, so the
+    // next record is taken right away
+    m_writer->Submit(m_current);
+    m_current = m_writer->Acquire();
+  }
+  else
+  {
+    FillTree();
+  }
+}
+
+void AnaManager::EndOfRunAction(const G4Run *aRun)
+{
+  // workers have all finished their runs when the master gets here
+  if (IsMergeMaster())
   {
-    PMTHit *aHit = (*PMTHC)[i];
+    MergeWorkerFiles();
+    return;
+  }
 
-    G4ThreeVector pos = aHit->GetPosition();
-    // m_pos.push_back(TVector3(pos.x(), pos.y(), pos.z()));
-    m_pos_x.push_back(pos.x());
-    m_pos_y.push_back(pos.y());
-    m_pos_z.push_back(pos.z());
+  if (m_writer)
+  {
+    m_writer->Stop();
+    m_writer->PrintStats();
+    m_writer.reset();
+    m_current = &m_tree_record;
+  }
 
-    G4double time = aHit->GetTime();
-    m_time.push_back(time);
+  if (m_file && m_file->IsOpen())
+  {
+    m_file->cd();
+    // replace the AutoSave cycles by the final header
+    m_tree->Write("", TObject::kOverwrite);
+    const Long64_t nentries = m_tree->GetEntries();
+    if (nentries > 0)
+      G4cout << "   Output tree  : " << nentries << " events, "
+             << m_tree->GetZipBytes() / nentries << " bytes/event compressed, "
+             << m_tree->GetTotBytes() / nentries << " bytes/event uncompressed" << G4endl;
+    Instrumentation::GetInstance().EndOfRun(m_file);
+    m_file->Close();
+  }
+  // the tree is owned and deleted by the file
+  delete m_file;
+  m_file = nullptr;
+  m_tree = nullptr;
+}
 
-    G4double energy = aHit->GetEnergy();
-    m_energy.push_back(energy);
+//_____________________________________________________________________________
+void AnaManager::FillTree()
+{
+  for (auto &column : m_hit_columns)
+    column.Stage();
+  m_tree->Fill();
+}
+
+//_____________________________________________________________________________
+G4bool AnaManager::IsMergeMaster() const
+{
+  return G4Threading::IsMultithreadedApplication() && G4Threading::IsMasterThread();
+}
+
+//_____________________________________________________________________________
+// <output>_<tag>.root, used for the files of worker threads and jobs
+G4String AnaManager::GetPartFilePath(const G4String &tag)
+{
+  TString path = m_output_rootfile_path.c_str();
+  TString suffix = TString::Format("_%s.root", tag.c_str());
+  if (path.EndsWith(".root"))
+    path.Replace(path.Length() - 5, 5, suffix);
+  else
+    path += suffix;
+  return G4String(path.Data());
+}
+
+//_____________________________________________________________________________
+void AnaManager::MergeWorkerFiles()
+{
+  const G4int nthreads = G4RunManager::GetRunManager()->GetNumberOfThreads();
+  std::vector<G4String> parts;
+  for (G4int i = 0; i < nthreads; ++i)
+    parts.push_back(GetPartFilePath("t" + std::to_string(i)));
+  MergePartFiles(parts);
+}
 
-    G4double wave_length = aHit->GetWaveLength();
-    m_wave_length.push_back(wave_length);
+//_____________________________________________________________________________
+// Merges the existing parts into the output path and deletes them.
+G4bool AnaManager::MergePartFiles(const std::vector<G4String> &candidates)
+{
+  TFileMerger merger(kFALSE);
+  merger.SetPrintLevel(0);
+  merger.OutputFile(m_output_rootfile_path.c_str(), "RECREATE", FileCompression());
 
-    G4int particle_id = aHit->GetParticleID();
-    m_particle_id.push_back(particle_id);
+  std::vector<G4String> parts;
+  for (const auto &part : candidates)
+  {
+    // AccessPathName() returns kTRUE if the file does NOT exist
+    if (gSystem->AccessPathName(part.c_str()))
+      continue;
+    merger.AddFile(part.c_str(), kFALSE);
+    parts.push_back(part);
+  }
 
-    G4int seg = aHit->GetCopyNumber();
-    m_seg.push_back(seg);
+  if (parts.empty())
+  {
+    G4cerr << "[AnaManager] Warning: no worker output to merge" << G4endl;
+    return false;
+  }
 
-    G4int detect_flag = aHit->GetDetectFlag();
-    m_detect_flag.push_back(detect_flag);
+  if (!merger.Merge())
+  {
+    G4cerr << "[AnaManager] Error: failed to merge worker files into "
+           << m_output_rootfile_path << ", worker files are kept" << G4endl;
+    return false;
   }
 
-  m_tree->Fill();
-  m_evnum++;
-  G4cout << m_evnum << ", " << m_nhit_pmt << G4endl;
+  for (const auto &part : parts)
+    gSystem->Unlink(part.c_str());
+  return true;
 }
 
-void AnaManager::EndOfRunAction(const G4Run *aRun)
+void AnaManager::ResetContainer()
 {
-  if (m_file && m_file->IsOpen())
+  m_current->ClearHits();
+  m_current->absorbed_blacksheet = 0;
+  m_current->absorbed_teflon = 0;
+  m_current->absorbed_pom = 0;
+  m_current->killed_escape = 0;
+  m_current->killed_time_gate = 0;
+  m_current->killed_max_length = 0;
+  m_current->killed_max_boundaries = 0;
+  m_current->prefiltered = 0;
+}
+
+G4int AnaManager::GetNumOfDetectedPhotons() const
+{
+  return static_cast<G4int>(std::count(m_current->detect_flag.begin(), m_current->detect_flag.end(), 1));
+}
+
+void AnaManager::AddPMTHit(const G4ThreeVector &pos, G4double time, G4double energy,
+                           G4double wave_length, G4int particle_id, G4int seg,
+                           G4int detect_flag)
+{
+  EventRecord &r = *m_current;
+  r.pos_x.push_back(pos.x());
+  r.pos_y.push_back(pos.y());
+  r.pos_z.push_back(pos.z());
+  r.time.push_back(time);
+  r.energy.push_back(energy);
+  if (m_store_wave_length)
+    r.wave_length.push_back(wave_length);
+  r.particle_id.push_back(particle_id);
+  r.seg.push_back(seg);
+  r.detect_flag.push_back(detect_flag);
+}
+
+void AnaManager::AddAbsorbedPhoton(G4int absorber)
+{
+  switch (absorber)
   {
-    m_file->cd();
-    m_tree->Write();
-    m_file->Close();
+  case SteppingAction::kBlackSheet:
+    ++m_current->absorbed_blacksheet;
+    break;
+  case SteppingAction::kTeflon:
+    ++m_current->absorbed_teflon;
+    break;
+  case SteppingAction::kPOM:
+    ++m_current->absorbed_pom;
+    break;
   }
 }
 
-void AnaManager::ResetContainer()
+void AnaManager::AddKilledPhoton(G4int policy)
 {
-  // m_pos.clear();
-  m_pos_x.clear();
-  m_pos_y.clear();
-  m_pos_z.clear();
-  m_time.clear();
-  m_energy.clear();
-  m_wave_length.clear();
-  m_particle_id.clear();
-  m_seg.clear();
-  m_detect_flag.clear();
+  switch (policy)
+  {
+  case SteppingAction::kKillEscape:
+    ++m_current->killed_escape;
+    break;
+  case SteppingAction::kKillTimeGate:
+    ++m_current->killed_time_gate;
+    break;
+  case SteppingAction::kKillMaxLength:
+    ++m_current->killed_max_length;
+    break;
+  case SteppingAction::kKillMaxBoundaries:
+    ++m_current->killed_max_boundaries;
+    break;
+  }
 }
 
 void AnaManager::SetNumOfCerenkovAll(G4int cerenkov_all)
 {
-  m_cerenkov_all = cerenkov_all;
+  m_current->cerenkov_all = cerenkov_all;
 }
 
 void AnaManager::SetNumOfCerenkovAerogel(G4int cerenkov_aerogel)
 {
-  m_cerenkov_aerogel = cerenkov_aerogel;
+  m_current->cerenkov_aerogel = cerenkov_aerogel;
+}
+
+void AnaManager::SetNumOfCerenkovGlass(G4int cerenkov_glass)
+{
+  m_current->cerenkov_glass = cerenkov_glass;
+}
+
+void AnaManager::SetNumOfCerenkovTeflon(G4int cerenkov_teflon)
+{
+  m_current->cerenkov_teflon = cerenkov_teflon;
+}
+
+void AnaManager::SetNumOfCerenkovPOM(G4int cerenkov_pom)
+{
+  m_current->cerenkov_pom = cerenkov_pom;
+}
+
+void AnaManager::SetNumOfCerenkovBlackSheet(G4int cerenkov_blacksheet)
+{
+  m_current->cerenkov_blacksheet = cerenkov_blacksheet;
+}
+
+void AnaManager::SetNumOfCerenkovSkippedMaterial(G4int skipped_material)
+{
+  m_current->cerenkov_skipped_material = skipped_material;
+}
+
+void AnaManager::SetNumOfCerenkovSkippedBand(G4int skipped_band)
+{
+  m_current->cerenkov_skipped_band = skipped_band;
+}
+
+void AnaManager::SetPrefiltered()
+{
+  m_current->prefiltered = 1;
+}
+
+void AnaManager::SetEventSeed(G4long event_seed)
+{
+  m_current->event_seed = event_seed;
 }
 
 void AnaManager::SetBeamEnergy(G4double beam_energy)
 {
-  m_beam_energy = beam_energy;
+  m_current->beam_energy = beam_energy;
 }
 
 void AnaManager::SetBeamMomentum(G4ThreeVector beam_momentum)
 {
-  m_beam_mom_x = beam_momentum.x();
-  m_beam_mom_y = beam_momentum.y();
-  m_beam_mom_z = beam_momentum.z();
+  m_current->beam_mom_x = beam_momentum.x();
+  m_current->beam_mom_y = beam_momentum.y();
+  m_current->beam_mom_z = beam_momentum.z();
 }
 
 void AnaManager::SetBeamPosition(G4ThreeVector beam_position)
 {
-  m_beam_pos_x = beam_position.x();
-  m_beam_pos_y = beam_position.y();
-  m_beam_pos_z = beam_position.z();
+  m_current->beam_pos_x = beam_position.x();
+  m_current->beam_pos_y = beam_position.y();
+  m_current->beam_pos_z = beam_position.z();
 }
 
 void AnaManager::SetOutputRootfilePath(G4String output_rootfile_path)
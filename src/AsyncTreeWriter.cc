@@ -0,0 +1,125 @@
+#include "AsyncTreeWriter.hh"
+
+#include <algorithm>
+#include <chrono>
+
+#include "G4ios.hh"
+
+namespace
+{
+  using Clock = std::chrono::steady_clock;
+
+  G4double SecondsSince(Clock::time_point start)
+  {
+    return std::chrono::duration<G4double>(Clock::now() - start).count();
+  }
+}
+
+//_____________________________________________________________________________
+AsyncTreeWriter::AsyncTreeWriter(EventRecord &tree_record, std::function<void()> fill,
+                                 std::size_t depth)
+    : m_tree_record(tree_record),
+      m_fill(fill),
+      m_stop(false),
+      m_nsubmit(0),
+      m_max_depth(0),
+      m_sum_depth(0.),
+      m_stall_time(0.),
+      m_write_time(0.)
+{
+  depth = std::max<std::size_t>(depth, 2);
+  for (std::size_t i = 0; i < depth; ++i)
+  {
+    m_pool.emplace_back(new EventRecord);
+    m_free.push_back(m_pool.back().get());
+  }
+  m_thread = std::thread(&AsyncTreeWriter::Run, this);
+}
+
+//_____________________________________________________________________________
+AsyncTreeWriter::~AsyncTreeWriter()
+{
+  Stop();
+}
+
+//_____________________________________________________________________________
+EventRecord *AsyncTreeWriter::Acquire()
+{
+  std::unique_lock<std::mutex> lock(m_mutex);
+  if (m_free.empty())
+  {
+    const auto start = Clock::now();
+    m_cv_free.wait(lock, [this]
+                   { return !m_free.empty(); });
+    m_stall_time += SecondsSince(start);
+  }
+  EventRecord *record = m_free.back();
+  m_free.pop_back();
+  return record;
+}
+
+//_____________________________________________________________________________
+void AsyncTreeWriter::Submit(EventRecord *record)
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_full.push_back(record);
+    ++m_nsubmit;
+    m_max_depth = std::max(m_max_depth, m_full.size());
+    m_sum_depth += m_full.size();
+  }
+  m_cv_full.notify_one();
+}
+
+//_____________________________________________________________________________
+void AsyncTreeWriter::Stop()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stop = true;
+  }
+  m_cv_full.notify_one();
+  if (m_thread.joinable())
+    m_thread.join();
+}
+
+//_____________________________________________________________________________
+void AsyncTreeWriter::Run()
+{
+  while (true)
+  {
+    EventRecord *record = nullptr;
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_cv_full.wait(lock, [this]
+                     { return m_stop || !m_full.empty(); });
+      // pending records are still written after Stop()
+      if (m_full.empty())
+        return;
+      record = m_full.front();
+      m_full.pop_front();
+    }
+
+    const auto start = Clock::now();
+    m_tree_record.TakeFrom(*record);
+    m_fill();
+    m_write_time += SecondsSince(start);
+
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_free.push_back(record);
+    }
+    m_cv_free.notify_one();
+  }
+}
+
+//_____________________________________________________________________________
+void AsyncTreeWriter::PrintStats() const
+{
+  const G4double mean_depth = m_nsubmit > 0 ? m_sum_depth / m_nsubmit : 0.;
+  G4cout << "   Async writer : " << m_nsubmit << " events"
+         << ", queue depth mean " << mean_depth
+         << " max " << m_max_depth << "/" << m_pool.size()
+         << ", simulation stalled " << m_stall_time << " s"
+         << ", writer busy " << m_write_time << " s" << G4endl;
+}
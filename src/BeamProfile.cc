@@ -0,0 +1,270 @@
+#include "BeamProfile.hh"
+
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "G4Exception.hh"
+#include "G4ios.hh"
+#include "Randomize.hh"
+
+#include "TFile.h"
+#include "TTree.h"
+
+//_____________________________________________________________________________
+std::shared_ptr<const BeamProfile> BeamProfile::Get()
+{
+  static std::mutex mutex;
+  static std::shared_ptr<const BeamProfile> current;
+  static BeamConfig loaded;
+
+  const BeamConfig &beam = ConfManager::GetInstance().GetConfig().beam;
+  std::lock_guard<std::mutex> lock(mutex);
+  if (!current || beam.beamfile != loaded.beamfile || beam.run != loaded.run ||
+      beam.sampling != loaded.sampling || beam.alias_bins != loaded.alias_bins)
+  {
+    current.reset(new BeamProfile(beam));
+    loaded = beam;
+  }
+  return current;
+}
+
+//_____________________________________________________________________________
+BeamProfile::BeamProfile(const BeamConfig &beam)
+    : m_sampling(beam.sampling),
+      m_entries(nullptr),
+      m_nentries(0),
+      m_map(nullptr),
+      m_map_size(0),
+      m_nbins(0),
+      m_xmin(0.), m_ymin(0.), m_dx(0.), m_dy(0.)
+{
+  if (beam.beamfile.empty())
+  {
+    G4cerr << "[BeamProfile] Warning: no beamfile given, using a pencil beam at (0, 0)" << G4endl;
+    m_owned.assign(1, BeamEntry{0.f, 0.f, 0.f, 0.f, 0.f});
+    m_entries = m_owned.data();
+    m_nentries = 1;
+    m_sampling = BeamConfig::Cyclic;
+    return;
+  }
+
+  const G4String path = "../conf/BeamProfile/" + beam.beamfile;
+  if (path.size() > 4 && path.compare(path.size() - 4, 4, ".bin") == 0)
+    MapBinary(path, beam.run);
+  else
+    LoadROOT(path);
+  if (m_sampling == BeamConfig::Alias)
+    BuildAliasTable(beam.alias_bins);
+
+  G4cout << "   Beam profile : " << GetNumOfEntries() << " entries from "
+         << beam.beamfile << G4endl;
+}
+
+//_____________________________________________________________________________
+BeamProfile::~BeamProfile()
+{
+  if (m_map)
+    munmap(m_map, m_map_size);
+}
+
+//_____________________________________________________________________________
+void BeamProfile::LoadROOT(const G4String &path)
+{
+  TFile *file = TFile::Open(path.c_str());
+  TTree *tree = file ? dynamic_cast<TTree *>(file->Get("beam")) : nullptr;
+  if (!tree)
+  {
+    G4ExceptionDescription msg;
+    msg << "Cannot read the beam tree from " << path;
+    G4Exception("BeamProfile::LoadROOT", "NoBeamProfile", FatalException, msg);
+    return;
+  }
+
+  G4double x = 0., y = 0.;
+  tree->SetBranchStatus("*", false);
+  tree->SetBranchStatus("x", true);
+  tree->SetBranchStatus("y", true);
+  tree->SetBranchAddress("x", &x);
+  tree->SetBranchAddress("y", &y);
+
+  const Long64_t nentries = tree->GetEntries();
+  m_owned.reserve(nentries);
+  for (Long64_t i = 0; i < nentries; ++i)
+  {
+    tree->GetEntry(i);
+    m_owned.push_back({static_cast<float>(x), static_cast<float>(y), 0.f, 0.f, 0.f});
+  }
+  delete file;
+
+  if (m_owned.empty())
+    G4Exception("BeamProfile::LoadROOT", "NoBeamProfile", FatalException,
+                ("Empty beam tree in " + path).c_str());
+  m_entries = m_owned.data();
+  m_nentries = m_owned.size();
+}
+
+//_____________________________________________________________________________
+// Selects one run of the file, or the only run when run < 0.
+void BeamProfile::MapBinary(const G4String &path, G4int run)
+{
+  using namespace BeamPhaseSpace;
+
+  G4ExceptionDescription msg;
+  const int fd = open(path.c_str(), O_RDONLY);
+  struct stat st;
+  if (fd < 0 || fstat(fd, &st) != 0)
+  {
+    msg << "Cannot open " << path;
+    G4Exception("BeamProfile::MapBinary", "NoBeamProfile", FatalException, msg);
+    return;
+  }
+  m_map_size = st.st_size;
+  m_map = mmap(nullptr, m_map_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (m_map == MAP_FAILED)
+  {
+    m_map = nullptr;
+    msg << "Cannot map " << path;
+    G4Exception("BeamProfile::MapBinary", "NoBeamProfile", FatalException, msg);
+    return;
+  }
+
+  const char *base = static_cast<const char *>(m_map);
+  const auto *header = reinterpret_cast<const BeamFileHeader *>(base);
+  if (m_map_size < sizeof(BeamFileHeader) ||
+      std::memcmp(header->magic, kMagic, sizeof(kMagic)) != 0 ||
+      header->entry_size != sizeof(BeamEntry) ||
+      m_map_size < sizeof(BeamFileHeader) + header->nruns * sizeof(BeamRunIndex))
+  {
+    msg << path << " is not a beam phase-space file";
+    G4Exception("BeamProfile::MapBinary", "BadBeamProfile", FatalException, msg);
+    return;
+  }
+
+  const auto *index = reinterpret_cast<const BeamRunIndex *>(base + sizeof(BeamFileHeader));
+  const BeamRunIndex *selected = nullptr;
+  if (run < 0 && header->nruns == 1)
+    selected = index;
+  for (std::uint32_t i = 0; i < header->nruns && run >= 0; ++i)
+  {
+    if (index[i].run == run)
+      selected = &index[i];
+  }
+  if (!selected || selected->nentries == 0 ||
+      selected->offset + selected->nentries * sizeof(BeamEntry) > m_map_size)
+  {
+    msg << "No usable run " << run << " in " << path << " (" << header->nruns
+        << " runs, set beam_run to select one)";
+    G4Exception("BeamProfile::MapBinary", "NoBeamRun", FatalException, msg);
+    return;
+  }
+  m_entries = reinterpret_cast<const BeamEntry *>(base + selected->offset);
+  m_nentries = selected->nentries;
+}
+
+//_____________________________________________________________________________
+void BeamProfile::BuildAliasTable(G4int nbins)
+{
+  G4double xmax = m_entries[0].x, ymax = m_entries[0].y;
+  m_xmin = xmax;
+  m_ymin = ymax;
+  for (std::size_t i = 0; i < m_nentries; ++i)
+  {
+    m_xmin = std::min<G4double>(m_xmin, m_entries[i].x);
+    xmax = std::max<G4double>(xmax, m_entries[i].x);
+    m_ymin = std::min<G4double>(m_ymin, m_entries[i].y);
+    ymax = std::max<G4double>(ymax, m_entries[i].y);
+  }
+  m_nbins = nbins;
+  // widen a degenerate axis so that the bin width stays finite
+  m_dx = std::max(xmax - m_xmin, 1e-6) / nbins;
+  m_dy = std::max(ymax - m_ymin, 1e-6) / nbins;
+
+  const G4int ncells = nbins * nbins;
+  std::vector<G4int> cell_of(m_nentries);
+  m_cell_start.assign(ncells + 1, 0);
+  for (std::size_t i = 0; i < m_nentries; ++i)
+  {
+    const G4int ix = std::min(static_cast<G4int>((m_entries[i].x - m_xmin) / m_dx), nbins - 1);
+    const G4int iy = std::min(static_cast<G4int>((m_entries[i].y - m_ymin) / m_dy), nbins - 1);
+    cell_of[i] = ix * nbins + iy;
+    ++m_cell_start[cell_of[i] + 1];
+  }
+  for (G4int c = 0; c < ncells; ++c)
+    m_cell_start[c + 1] += m_cell_start[c];
+  m_cell_entries.resize(m_nentries);
+  std::vector<std::size_t> fill(m_cell_start.begin(), m_cell_start.end() - 1);
+  for (std::size_t i = 0; i < m_nentries; ++i)
+    m_cell_entries[fill[cell_of[i]]++] = i;
+
+  // Vose's construction: scaled weights below 1 are topped up by an alias
+  const G4double scale = ncells / static_cast<G4double>(m_nentries);
+  std::vector<G4double> weight(ncells);
+  std::vector<G4int> small, large;
+  for (G4int c = 0; c < ncells; ++c)
+  {
+    weight[c] = (m_cell_start[c + 1] - m_cell_start[c]) * scale;
+    (weight[c] < 1. ? small : large).push_back(c);
+  }
+  m_alias_prob.assign(ncells, 1.);
+  m_alias.resize(ncells);
+  for (G4int c = 0; c < ncells; ++c)
+    m_alias[c] = c;
+  while (!small.empty() && !large.empty())
+  {
+    const G4int s = small.back();
+    small.pop_back();
+    const G4int l = large.back();
+    m_alias_prob[s] = weight[s];
+    m_alias[s] = l;
+    weight[l] -= 1. - weight[s];
+    if (weight[l] < 1.)
+    {
+      large.pop_back();
+      small.push_back(l);
+    }
+  }
+}
+
+//_____________________________________________________________________________
+G4bool BeamProfile::Sample(G4long index, BeamEntry &entry) const
+{
+  const std::size_t n = m_nentries;
+  std::size_t i = 0;
+  switch (m_sampling)
+  {
+  case BeamConfig::Sequential:
+    if (index < 0 || static_cast<std::size_t>(index) >= n)
+      return false;
+    i = index;
+    break;
+  case BeamConfig::Cyclic:
+    i = index % n;
+    break;
+  case BeamConfig::Random:
+    i = std::min(static_cast<std::size_t>(G4UniformRand() * n), n - 1);
+    break;
+  case BeamConfig::Alias:
+  {
+    const G4int ncells = static_cast<G4int>(m_alias.size());
+    const G4double u = G4UniformRand() * ncells;
+    G4int cell = std::min(static_cast<G4int>(u), ncells - 1);
+    if (u - cell >= m_alias_prob[cell])
+      cell = m_alias[cell];
+    // cells drawn here always hold at least one entry
+    const std::size_t first = m_cell_start[cell];
+    const std::size_t count = m_cell_start[cell + 1] - first;
+    entry = m_entries[m_cell_entries[first + std::min(static_cast<std::size_t>(G4UniformRand() * count), count - 1)]];
+    entry.x = m_xmin + (cell / m_nbins + G4UniformRand()) * m_dx;
+    entry.y = m_ymin + (cell % m_nbins + G4UniformRand()) * m_dy;
+    return true;
+  }
+  }
+  entry = m_entries[i];
+  return true;
+}
@@ -0,0 +1,132 @@
+#include "BoundaryValidation.hh"
+
+#include "G4ios.hh"
+
+#include "TMath.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+  const char *const kKindNames[BoundaryValidation::kNKinds] = {
+      "front painted", "back painted, no RINDEX"};
+  const char *const kOutcomeNames[BoundaryValidation::kNOutcomes] = {
+      "reflected", "transmitted", "absorbed", "killed", "other"};
+
+  BoundaryValidation::Outcome ToOutcome(G4OpBoundaryProcessStatus status)
+  {
+    switch (status)
+    {
+    case FresnelReflection:
+    case TotalInternalReflection:
+    case LambertianReflection:
+    case LobeReflection:
+    case SpikeReflection:
+    case BackScattering:
+      return BoundaryValidation::Reflected;
+    case FresnelRefraction:
+    case Transmission:
+      return BoundaryValidation::Transmitted;
+    case Absorption:
+    case Detection:
+      return BoundaryValidation::Absorbed;
+    case NoRINDEX:
+      return BoundaryValidation::Killed;
+    default:
+      return BoundaryValidation::Other;
+    }
+  }
+
+  G4long Sum(const std::vector<G4long> &bins)
+  {
+    G4long n = 0;
+    for (const G4long count : bins)
+      n += count;
+    return n;
+  }
+}
+
+//_____________________________________________________________________________
+void BoundaryValidation::Tally::Add(G4OpBoundaryProcessStatus status, G4double cos_reflection)
+{
+  const Outcome outcome = ToOutcome(status);
+  ++outcomes[outcome];
+  if (outcome == Reflected)
+    ++cos_theta[std::min(std::max(G4int(cos_reflection * kNBins), 0), kNBins - 1)];
+}
+
+//_____________________________________________________________________________
+void BoundaryValidation::Tally::Merge(const Tally &other)
+{
+  for (G4int i = 0; i < kNOutcomes; ++i)
+    outcomes[i] += other.outcomes[i];
+  for (G4int i = 0; i < kNBins; ++i)
+    cos_theta[i] += other.cos_theta[i];
+}
+
+//_____________________________________________________________________________
+BoundaryValidation &BoundaryValidation::GetInstance()
+{
+  static BoundaryValidation instance;
+  return instance;
+}
+
+//_____________________________________________________________________________
+void BoundaryValidation::Merge(const Tallies &tallies)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  for (G4int k = 0; k < kNKinds; ++k)
+  {
+    m_tallies.fast[k].Merge(tallies.fast[k]);
+    m_tallies.stock[k].Merge(tallies.stock[k]);
+  }
+}
+
+//_____________________________________________________________________________
+void BoundaryValidation::Report()
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  for (G4int k = 0; k < kNKinds; ++k)
+  {
+    const Tally &fast = m_tallies.fast[k];
+    const Tally &stock = m_tallies.stock[k];
+    G4long nfast = 0, nstock = 0;
+    for (G4int i = 0; i < kNOutcomes; ++i)
+    {
+      nfast += fast.outcomes[i];
+      nstock += stock.outcomes[i];
+    }
+    if (nfast == 0 || nstock == 0)
+      continue;
+
+    G4cout << "   Boundary validation, " << kKindNames[k] << ": "
+           << nstock << " photons" << G4endl;
+    for (G4int i = 0; i < kNOutcomes; ++i)
+    {
+      if (fast.outcomes[i] == 0 && stock.outcomes[i] == 0)
+        continue;
+      G4cout << "      " << kOutcomeNames[i] << ": fast "
+             << G4double(fast.outcomes[i]) / nfast << ", stock "
+             << G4double(stock.outcomes[i]) / nstock << G4endl;
+    }
+
+    // binned two-sample KS test on cos(theta) of the reflections
+    const G4long nfast_refl = Sum(fast.cos_theta);
+    const G4long nstock_refl = Sum(stock.cos_theta);
+    if (nfast_refl > 0 && nstock_refl > 0)
+    {
+      G4double cdf_fast = 0., cdf_stock = 0., distance = 0.;
+      for (G4int i = 0; i < kNBins; ++i)
+      {
+        cdf_fast += G4double(fast.cos_theta[i]) / nfast_refl;
+        cdf_stock += G4double(stock.cos_theta[i]) / nstock_refl;
+        distance = std::max(distance, std::abs(cdf_fast - cdf_stock));
+      }
+      const G4double n_eff = G4double(nfast_refl) * nstock_refl / (nfast_refl + nstock_refl);
+      G4cout << "      reflection angle: KS distance " << distance
+             << ", p-value " << TMath::KolmogorovProb(distance * std::sqrt(n_eff)) << G4endl;
+    }
+  }
+  m_tallies = Tallies();
+}
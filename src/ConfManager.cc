@@ -1,59 +1,376 @@
 #include "ConfManager.hh"
 #include <fstream>
+#include <functional>
+#include <map>
+#include <set>
 #include <sstream>
-#include <iostream>
+#include <stdexcept>
 
-ConfManager& ConfManager::GetInstance() {
-    static ConfManager instance;
-    return instance;
+namespace {
+
+using KeyParser = std::function<void(SACConfig&, const std::string&)>;
+
+struct KeyDef {
+    KeyParser parse;
+    bool required;
+};
+
+double ToDouble(const std::string& value) {
+    std::size_t pos = 0;
+    double result = std::stod(value, &pos);
+    if (pos != value.size()) {
+        throw std::invalid_argument("not a number");
+    }
+    return result;
 }
 
-ConfManager::ConfManager() {}
+int ToInt(const std::string& value) {
+    std::size_t pos = 0;
+    int result = std::stoi(value, &pos);
+    if (pos != value.size()) {
+        throw std::invalid_argument("not an integer");
+    }
+    return result;
+}
+
+long long ToLong(const std::string& value) {
+    std::size_t pos = 0;
+    long long result = std::stoll(value, &pos);
+    if (pos != value.size()) {
+        throw std::invalid_argument("not an integer");
+    }
+    return result;
+}
+
+bool ToBool(const std::string& value) {
+    int result = ToInt(value);
+    if (result != 0 && result != 1) {
+        throw std::invalid_argument("not 0 or 1");
+    }
+    return result == 1;
+}
+
+BeamConfig::Sampling ToSampling(const std::string& value) {
+    if (value == "sequential") {
+        return BeamConfig::Sequential;
+    } else if (value == "cyclic") {
+        return BeamConfig::Cyclic;
+    } else if (value == "random") {
+        return BeamConfig::Random;
+    } else if (value == "alias") {
+        return BeamConfig::Alias;
+    }
+    throw std::invalid_argument("unknown sampling");
+}
 
-void ConfManager::Set(const std::string& key, const std::string& value) {
-    config_map[key] = value;
+GeometryConfig::FrameConstruction ToFrameConstruction(const std::string& value) {
+    if (value == "boolean") {
+        return GeometryConfig::FrameBoolean;
+    } else if (value == "segments") {
+        return GeometryConfig::FrameSegments;
+    }
+    throw std::invalid_argument("not boolean or segments");
 }
 
-std::string ConfManager::Get(const std::string& key) const {
-    auto it = config_map.find(key);
-    if (it != config_map.end()) {
-        return it->second;
+std::string ToCompression(const std::string& value) {
+    if (value == "zlib" || value == "lzma" || value == "lz4" || value == "zstd") {
+        return value;
     }
-    std::cerr << "Warning: Config key '" << key << "' not found!" << std::endl;
-    return "";
+    throw std::invalid_argument("not zlib, lzma, lz4 or zstd");
 }
 
-double ConfManager::GetDouble(const std::string& key) const {
-    auto it = config_map.find(key);
-    if (it != config_map.end()) {
-        return std::stod(it->second);
+OpticsConfig::Boundary ToBoundary(const std::string& value) {
+    if (value == "stock") {
+        return OpticsConfig::BoundaryStock;
+    } else if (value == "fast") {
+        return OpticsConfig::BoundaryFast;
+    } else if (value == "validate") {
+        return OpticsConfig::BoundaryValidate;
     }
-    std::cerr << "Warning: Config key '" << key << "' not found!" << std::endl;
-    return 0.0;
+    throw std::invalid_argument("not stock, fast or validate");
 }
 
-int ConfManager::GetInt(const std::string& key) const {
-    auto it = config_map.find(key);
-    if (it != config_map.end()) {
-        return std::stoi(it->second);
+double ToCut(const std::string& value) {
+    double result = ToDouble(value);
+    if (result < 0.) {
+        throw std::invalid_argument("negative cut");
+    }
+    return result;
+}
+
+std::vector<std::string> ToMaterials(const std::string& value) {
+    std::vector<std::string> result;
+    if (value == "all") {
+        return result;
+    }
+    std::istringstream iss(value);
+    std::string name;
+    while (std::getline(iss, name, ',')) {
+        if (name.empty()) {
+            throw std::invalid_argument("empty material name");
+        }
+        result.push_back(name);
     }
-    std::cerr << "Warning: Config key '" << key << "' not found!" << std::endl;
-    return 0;
+    return result;
 }
 
+// none, pmt or <min>,<max> in eV
+void ToCerenkovBand(OpticsConfig& optics, const std::string& value) {
+    optics.cerenkov_band_pmt = false;
+    optics.cerenkov_band_min = 0.;
+    optics.cerenkov_band_max = 0.;
+    if (value == "none") {
+        return;
+    } else if (value == "pmt") {
+        optics.cerenkov_band_pmt = true;
+        return;
+    }
+    const std::size_t comma = value.find(',');
+    if (comma == std::string::npos) {
+        throw std::invalid_argument("not none, pmt or <min>,<max>");
+    }
+    optics.cerenkov_band_min = ToDouble(value.substr(0, comma));
+    optics.cerenkov_band_max = ToDouble(value.substr(comma + 1));
+    if (optics.cerenkov_band_min < 0. || optics.cerenkov_band_max <= optics.cerenkov_band_min) {
+        throw std::invalid_argument("need 0 <= min < max");
+    }
+}
+
+// double, float, float16, double32, float16[min,max,nbits] or
+// double32[min,max,nbits]
+ColumnPrecision ToPrecision(const std::string& value) {
+    ColumnPrecision result;
+    const std::string type = value.substr(0, value.find('['));
+    if (type == "double") {
+        result.type = ColumnPrecision::Double;
+    } else if (type == "float") {
+        result.type = ColumnPrecision::Float;
+    } else if (type == "float16") {
+        result.type = ColumnPrecision::Float16;
+    } else if (type == "double32") {
+        result.type = ColumnPrecision::Double32;
+    } else {
+        throw std::invalid_argument("unknown precision");
+    }
+    if (type.size() == value.size()) {
+        return result;
+    }
+    if (result.type != ColumnPrecision::Float16 && result.type != ColumnPrecision::Double32) {
+        throw std::invalid_argument("range only allowed for float16 and double32");
+    }
+    if (value.back() != ']') {
+        throw std::invalid_argument("missing ']'");
+    }
+    std::istringstream range(value.substr(type.size() + 1, value.size() - type.size() - 2));
+    std::string min, max, nbits, extra;
+    if (!std::getline(range, min, ',') || !std::getline(range, max, ',') ||
+        !std::getline(range, nbits, ',') || std::getline(range, extra, ',')) {
+        throw std::invalid_argument("expected [min,max,nbits]");
+    }
+    result.min = ToDouble(min);
+    result.max = ToDouble(max);
+    result.nbits = ToInt(nbits);
+    if (result.max <= result.min || result.nbits < 2 || result.nbits > 32) {
+        throw std::invalid_argument("need min < max and 2 <= nbits <= 32");
+    }
+    return result;
+}
+
+// Every key accepted in a conf file. Anything else is rejected.
+const std::map<std::string, KeyDef>& KeyTable() {
+    static const std::map<std::string, KeyDef> table = {
+        // general
+        {"decay", {[](SACConfig& c, const std::string& v) { c.general.decay = ToInt(v); }, true}},
+        {"nthreads", {[](SACConfig& c, const std::string& v) { c.general.nthreads = ToInt(v); }, false}},
+        {"physics_list", {[](SACConfig& c, const std::string& v) { c.general.physics_list = v; }, false}},
+        {"em_option", {[](SACConfig& c, const std::string& v) { c.general.em_option = ToInt(v); }, false}},
+        {"physics_table_cache", {[](SACConfig& c, const std::string& v) { c.general.physics_table_cache = v; }, false}},
+        {"verbose", {[](SACConfig& c, const std::string& v) { c.general.verbose = ToInt(v); }, false}},
+        {"progress_interval", {[](SACConfig& c, const std::string& v) { c.general.progress_interval = ToDouble(v); }, false}},
+        {"instrumentation", {[](SACConfig& c, const std::string& v) { c.general.instrumentation = ToBool(v); }, false}},
+        // beam
+        {"particle", {[](SACConfig& c, const std::string& v) { c.beam.particle = v; }, true}},
+        {"momentum", {[](SACConfig& c, const std::string& v) { c.beam.momentum = ToDouble(v); }, true}},
+        {"beamfile", {[](SACConfig& c, const std::string& v) { c.beam.beamfile = v; }, false}},
+        {"beam_run", {[](SACConfig& c, const std::string& v) { c.beam.run = ToInt(v); }, false}},
+        {"beam_sampling", {[](SACConfig& c, const std::string& v) { c.beam.sampling = ToSampling(v); }, false}},
+        {"beam_alias_bins", {[](SACConfig& c, const std::string& v) { c.beam.alias_bins = ToInt(v); }, false}},
+        // geometry
+        {"gel_size_x", {[](SACConfig& c, const std::string& v) { c.geometry.gel_size_x = ToDouble(v); }, true}},
+        {"gel_size_y", {[](SACConfig& c, const std::string& v) { c.geometry.gel_size_y = ToDouble(v); }, true}},
+        {"gel_size_z", {[](SACConfig& c, const std::string& v) { c.geometry.gel_size_z = ToDouble(v); }, true}},
+        {"teflon_thickness", {[](SACConfig& c, const std::string& v) { c.geometry.teflon_thickness = ToDouble(v); }, true}},
+        {"BlackSheet_thickness", {[](SACConfig& c, const std::string& v) { c.geometry.blacksheet_thickness = ToDouble(v); }, true}},
+        {"frame_thickness", {[](SACConfig& c, const std::string& v) { c.geometry.frame_thickness = ToDouble(v); }, true}},
+        {"pmt_channel", {[](SACConfig& c, const std::string& v) { c.geometry.pmt_channel = ToInt(v); }, true}},
+        {"pmt_x_spacing", {[](SACConfig& c, const std::string& v) { c.geometry.pmt_x_spacing = ToDouble(v); }, true}},
+        {"pmt_y_spacing", {[](SACConfig& c, const std::string& v) { c.geometry.pmt_y_spacing = ToDouble(v); }, true}},
+        {"pmt_casing_radius", {[](SACConfig& c, const std::string& v) { c.geometry.pmt_casing_radius = ToDouble(v); }, true}},
+        {"pmt_window_radius", {[](SACConfig& c, const std::string& v) { c.geometry.pmt_window_radius = ToDouble(v); }, true}},
+        {"pmt_thickness", {[](SACConfig& c, const std::string& v) { c.geometry.pmt_thickness = ToDouble(v); }, true}},
+        {"frame_construction", {[](SACConfig& c, const std::string& v) { c.geometry.frame_construction = ToFrameConstruction(v); }, false}},
+        // optics
+        {"teflon_layer", {[](SACConfig& c, const std::string& v) { c.optics.teflon_layer = ToInt(v); }, true}},
+        {"SigmaAlpha", {[](SACConfig& c, const std::string& v) { c.optics.sigma_alpha = ToDouble(v); }, true}},
+        {"qe_culling", {[](SACConfig& c, const std::string& v) { c.optics.qe_culling = ToBool(v); }, false}},
+        {"absorber_kill", {[](SACConfig& c, const std::string& v) { c.optics.absorber_kill = ToBool(v); }, false}},
+        {"cerenkov_materials", {[](SACConfig& c, const std::string& v) { c.optics.cerenkov_materials = ToMaterials(v); }, false}},
+        {"cerenkov_band", {[](SACConfig& c, const std::string& v) { ToCerenkovBand(c.optics, v); }, false}},
+        {"event_prefilter", {[](SACConfig& c, const std::string& v) { c.optics.event_prefilter = ToBool(v); }, false}},
+        {"photon_kill_escape", {[](SACConfig& c, const std::string& v) { c.optics.photon_kill_escape = ToBool(v); }, false}},
+        {"photon_time_gate", {[](SACConfig& c, const std::string& v) { c.optics.photon_time_gate = ToDouble(v); }, false}},
+        {"photon_max_length", {[](SACConfig& c, const std::string& v) { c.optics.photon_max_length = ToDouble(v); }, false}},
+        {"photon_max_boundaries", {[](SACConfig& c, const std::string& v) { c.optics.photon_max_boundaries = ToInt(v); }, false}},
+        {"optical_boundary", {[](SACConfig& c, const std::string& v) { c.optics.boundary = ToBoundary(v); }, false}},
+        // production cuts
+        {"cut_aerogel", {[](SACConfig& c, const std::string& v) { c.cuts.aerogel = ToCut(v); }, false}},
+        {"cut_pmt_window", {[](SACConfig& c, const std::string& v) { c.cuts.pmt_window = ToCut(v); }, false}},
+        {"cut_passive", {[](SACConfig& c, const std::string& v) { c.cuts.passive = ToCut(v); }, false}},
+        {"cut_air", {[](SACConfig& c, const std::string& v) { c.cuts.air = ToCut(v); }, false}},
+        // output
+        {"tree_autoflush", {[](SACConfig& c, const std::string& v) { c.output.tree_autoflush = ToLong(v); }, false}},
+        {"tree_autosave", {[](SACConfig& c, const std::string& v) { c.output.tree_autosave = ToLong(v); }, false}},
+        {"async_output", {[](SACConfig& c, const std::string& v) { c.output.async_output = ToBool(v); }, false}},
+        {"output_queue_depth", {[](SACConfig& c, const std::string& v) { c.output.output_queue_depth = ToInt(v); }, false}},
+        {"output_imt_threads", {[](SACConfig& c, const std::string& v) { c.output.output_imt_threads = ToInt(v); }, false}},
+        {"compression", {[](SACConfig& c, const std::string& v) { c.output.compression = ToCompression(v); }, false}},
+        {"compression_level", {[](SACConfig& c, const std::string& v) { c.output.compression_level = ToInt(v); }, false}},
+        {"basket_size", {[](SACConfig& c, const std::string& v) { c.output.basket_size = ToInt(v); }, false}},
+        {"precision_pos", {[](SACConfig& c, const std::string& v) { c.output.precision_pos = ToPrecision(v); }, false}},
+        {"precision_time", {[](SACConfig& c, const std::string& v) { c.output.precision_time = ToPrecision(v); }, false}},
+        {"precision_energy", {[](SACConfig& c, const std::string& v) { c.output.precision_energy = ToPrecision(v); }, false}},
+        {"store_wave_length", {[](SACConfig& c, const std::string& v) { c.output.store_wave_length = ToBool(v); }, false}},
+    };
+    return table;
+}
+
+void Require(bool condition, const std::string& filename, const std::string& message) {
+    if (!condition) {
+        throw std::runtime_error("Error: " + filename + ": " + message);
+    }
+}
+
+void Validate(const SACConfig& c, const std::string& filename) {
+    Require(c.general.nthreads >= 1, filename, "nthreads must be >= 1");
+    Require(c.general.physics_list == "QGSP_BERT" || c.general.physics_list == "optical", filename,
+            "physics_list must be QGSP_BERT or optical");
+    Require(c.general.em_option >= 0 && c.general.em_option <= 4, filename, "em_option must be in [0, 4]");
+    Require(c.general.verbose >= 0, filename, "verbose must not be negative");
+    Require(c.general.progress_interval >= 0., filename, "progress_interval must not be negative");
+    Require(c.beam.momentum > 0., filename, "momentum must be positive");
+    Require(c.beam.alias_bins >= 1 && c.beam.alias_bins <= 4096, filename, "beam_alias_bins must be in [1, 4096]");
+    const auto& g = c.geometry;
+    Require(g.gel_size_x > 0. && g.gel_size_y > 0. && g.gel_size_z > 0., filename,
+            "gel_size_x/y/z must be positive");
+    Require(g.teflon_thickness > 0. && g.blacksheet_thickness > 0. && g.frame_thickness > 0., filename,
+            "teflon_thickness, BlackSheet_thickness and frame_thickness must be positive");
+    Require(g.pmt_channel == 8 || g.pmt_channel == 14, filename, "pmt_channel must be 8 or 14");
+    Require(g.pmt_window_radius > 0. && g.pmt_casing_radius > g.pmt_window_radius, filename,
+            "need 0 < pmt_window_radius < pmt_casing_radius");
+    Require(g.pmt_thickness > 0., filename, "pmt_thickness must be positive");
+    Require(c.optics.teflon_layer == 2 || c.optics.teflon_layer == 3, filename,
+            "teflon_layer must be 2 or 3");
+    Require(c.optics.sigma_alpha >= 0., filename, "SigmaAlpha must not be negative");
+    Require(c.optics.photon_time_gate >= 0. && c.optics.photon_max_length >= 0. &&
+                c.optics.photon_max_boundaries >= 0,
+            filename, "photon_time_gate, photon_max_length and photon_max_boundaries must not be negative");
+    Require(c.output.tree_autoflush != 0 && c.output.tree_autosave != 0, filename,
+            "tree_autoflush and tree_autosave must not be 0");
+    Require(c.output.output_queue_depth >= 2, filename, "output_queue_depth must be >= 2");
+    Require(c.output.output_imt_threads >= 0, filename, "output_imt_threads must not be negative");
+    Require(c.output.compression_level >= 0 && c.output.compression_level <= 9, filename,
+            "compression_level must be in [0, 9]");
+    Require(c.output.basket_size > 0, filename, "basket_size must be positive");
+}
+
+} // namespace
+
+ConfManager& ConfManager::GetInstance() {
+    static ConfManager instance;
+    return instance;
+}
+
+ConfManager::ConfManager() {}
+
 void ConfManager::LoadConfigFile(const std::string& filename) {
     std::ifstream file(filename);
     if (!file) {
-        std::cerr << "Error: Cannot open config file " << filename << std::endl;
-        return;
+        throw std::runtime_error("Error: Cannot open config file " + filename);
     }
 
+    const auto& table = KeyTable();
+    SACConfig parsed;
+    std::set<std::string> seen;
+
     std::string line;
+    int line_number = 0;
     while (std::getline(file, line)) {
+        ++line_number;
+        const std::string where = filename + ":" + std::to_string(line_number);
+
+        line = line.substr(0, line.find('#'));
         std::istringstream iss(line);
-        std::string key, value;
-        if (iss >> key >> value) {
-            config_map[key] = value;
+        std::string key, value, extra;
+        if (!(iss >> key)) {
+            continue;
+        }
+        if (!(iss >> value) || (iss >> extra)) {
+            throw std::runtime_error("Error: " + where + ": expected '<key> <value>' for '" + key + "'");
+        }
+
+        auto it = table.find(key);
+        if (it == table.end()) {
+            throw std::runtime_error("Error: " + where + ": unknown config key '" + key + "'");
+        }
+        if (!seen.insert(key).second) {
+            throw std::runtime_error("Error: " + where + ": duplicated config key '" + key + "'");
+        }
+        try {
+            it->second.parse(parsed, value);
+        } catch (const std::logic_error&) {
+            throw std::runtime_error("Error: " + where + ": malformed value '" + value + "' for '" + key + "'");
+        }
+    }
+
+    for (const auto& entry : table) {
+        if (entry.second.required && !seen.count(entry.first)) {
+            throw std::runtime_error("Error: " + filename + ": missing config key '" + entry.first + "'");
         }
     }
+
+    Validate(parsed, filename);
+    config = parsed;
+    ++generation;
+}
+
+void ConfManager::SetBeamFile(const std::string& beamfile) {
+    config.beam.beamfile = beamfile;
+    ++generation;
+}
+
+bool CutsDiffer(const SACConfig& a, const SACConfig& b) {
+    return a.cuts.aerogel != b.cuts.aerogel || a.cuts.pmt_window != b.cuts.pmt_window ||
+           a.cuts.passive != b.cuts.passive || a.cuts.air != b.cuts.air;
+}
+
+bool NeedsSteppingAction(const SACConfig& c) {
+    const auto& o = c.optics;
+    return c.general.instrumentation || o.absorber_kill || o.photon_kill_escape ||
+           o.photon_time_gate > 0. || o.photon_max_length > 0. || o.photon_max_boundaries > 0;
+}
+
+bool GeometryDiffers(const SACConfig& a, const SACConfig& b) {
+    const auto& ga = a.geometry;
+    const auto& gb = b.geometry;
+    return ga.gel_size_x != gb.gel_size_x || ga.gel_size_y != gb.gel_size_y ||
+           ga.gel_size_z != gb.gel_size_z || ga.teflon_thickness != gb.teflon_thickness ||
+           ga.blacksheet_thickness != gb.blacksheet_thickness ||
+           ga.frame_thickness != gb.frame_thickness || ga.pmt_channel != gb.pmt_channel ||
+           ga.pmt_x_spacing != gb.pmt_x_spacing || ga.pmt_y_spacing != gb.pmt_y_spacing ||
+           ga.pmt_casing_radius != gb.pmt_casing_radius ||
+           ga.pmt_window_radius != gb.pmt_window_radius || ga.pmt_thickness != gb.pmt_thickness ||
+           ga.frame_construction != gb.frame_construction ||
+           // the optical surfaces are part of the geometry
+           a.optics.teflon_layer != b.optics.teflon_layer ||
+           a.optics.sigma_alpha != b.optics.sigma_alpha;
 }
@@ -11,12 +11,13 @@
 #include "G4PhysicalVolumeStore.hh"
 #include "G4SystemOfUnits.hh"
 #include "G4ThreeVector.hh"
-#include "G4SubtractionSolid.hh"
 #include "G4SDManager.hh"
 #include "G4VisAttributes.hh"
 #include "G4Colour.hh"
 #include "CLHEP/Units/SystemOfUnits.h"
 #include "ConfManager.hh"
+#include "FrameSolids.hh"
+#include "RegionCuts.hh"
 #include "G4Tubs.hh"
 
 namespace
@@ -26,7 +27,8 @@ namespace
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 DetectorConstruction::DetectorConstruction()
-    : G4VUserDetectorConstruction(), m_check_overlaps(true)
+    : G4VUserDetectorConstruction(), m_world_lv(nullptr), m_pmt_window_lv(nullptr),
+      m_check_overlaps(true)
 {
 }
 
@@ -41,9 +43,14 @@ DetectorConstruction::Construct()
 {
   using CLHEP::m;
 
-  ConstructElements();
-  ConstructMaterials();
-  AddOpticalProperties();
+  // materials survive /run/reinitializeGeometry, build them only once
+  if (m_material_map.empty())
+  {
+    ConstructElements();
+    ConstructMaterials();
+    AddOpticalProperties();
+  }
+  ConstructOpticalSurfaces();
 
   auto world_solid = new G4Box("WorldSolid", 1. * m / 2, 1. * m / 2, 1. * m / 2);
   m_world_lv = new G4LogicalVolume(world_solid, m_material_map["Air"],
@@ -52,11 +59,27 @@ DetectorConstruction::Construct()
   auto world_pv = new G4PVPlacement(nullptr, G4ThreeVector(), m_world_lv,
                                     "World", nullptr, false, 0, m_check_overlaps);
 
+  RegionCuts::Create();
   ConstructSAC();
 
   return world_pv;
 }
 
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+// Called on every worker thread: sensitive detectors are thread-local
+void DetectorConstruction::ConstructSDandField()
+{
+  // reused when the geometry is rebuilt
+  auto sd_manager = G4SDManager::GetSDMpointer();
+  auto pmt_sd = sd_manager->FindSensitiveDetector("PMT_SD", false);
+  if (!pmt_sd)
+  {
+    pmt_sd = new PMTSD("PMT_SD");
+    sd_manager->AddNewDetector(pmt_sd);
+  }
+  SetSensitiveDetector(m_pmt_window_lv, pmt_sd);
+}
+
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 void DetectorConstruction::ConstructElements()
 {
@@ -335,45 +358,6 @@ void DetectorConstruction::AddOpticalProperties()
   teflon_prop->AddProperty("ABSLENGTH", &photon_energy[0], &absorption_length[0], n_entries);
   m_material_map["Teflon"]->SetMaterialPropertiesTable(teflon_prop);
 
-  // Optical surface settings: Aerogel ↔ Teflon sheet
-  const G4int teflon_layer = gConfMan.GetInt("teflon_layer");
-  const G4int SigmaAlpha = gConfMan.GetInt("SigmaAlpha");
-  if (teflon_layer == 2)
-  {
-    reflectivity = {0.85, 0.90, 0.93, 0.97, 0.98,
-                    0.99, 0.99, 1.00, 1.00, 1.00,
-                    1.00, 1.00, 1.00, 1.00, 1.00};
-  }
-  else if (teflon_layer == 3)
-  {
-    reflectivity = {0.90, 0.93, 0.96, 0.98, 1.00,
-                    0.99, 0.99, 1.00, 1.00, 1.00,
-                    1.00, 1.00, 1.00, 1.00, 1.00};
-  }
-
-  auto gel_steflon_prop = new G4MaterialPropertiesTable();
-  gel_steflon_prop->AddProperty("REFLECTIVITY", &photon_energy[0], &reflectivity[0], n_entries);
-  gel_steflon_surf = new G4OpticalSurface("GelTeflonSheetSurface");
-  gel_steflon_surf->SetType(dielectric_dielectric);
-  gel_steflon_surf->SetModel(unified);
-  gel_steflon_surf->SetFinish(groundbackpainted);
-  gel_steflon_surf->SetSigmaAlpha(SigmaAlpha); // roughness
-  gel_steflon_surf->SetMaterialPropertiesTable(gel_steflon_prop);
-
-  // Optical surface settings: Aerogel ↔ Teflon frame
-  reflectivity = {0.97, 0.98, 0.99, 1.00, 1.00,
-                  0.99, 0.99, 1.00, 1.00, 1.00,
-                  1.00, 1.00, 1.00, 1.00, 1.00};
-
-  auto gel_fteflon_prop = new G4MaterialPropertiesTable();
-  gel_fteflon_prop->AddProperty("REFLECTIVITY", &photon_energy[0], &reflectivity[0], n_entries);
-  gel_fteflon_surf = new G4OpticalSurface("GelTeflonFrameSurface");
-  gel_fteflon_surf->SetType(dielectric_dielectric);
-  gel_fteflon_surf->SetModel(unified);
-  gel_fteflon_surf->SetFinish(groundfrontpainted);
-  gel_fteflon_surf->SetSigmaAlpha(SigmaAlpha); // roughness
-  gel_fteflon_surf->SetMaterialPropertiesTable(gel_fteflon_prop);
-
   // +-----------------------------------------------------------------+
   // | PMT window (Glass) Property                                     |
   // | Ref: https://refractiveindex.info/?shelf=3d&book=glass&page=BK7 |
@@ -437,6 +421,61 @@ void DetectorConstruction::AddOpticalProperties()
   m_material_map["POM"]->SetMaterialPropertiesTable(pom_prop);
 }
 
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+// The surfaces depend on the optics settings and are deleted with the
+// geometry, so they are rebuilt by every Construct().
+void DetectorConstruction::ConstructOpticalSurfaces()
+{
+  using CLHEP::eV;
+
+  // Teflon energies
+  std::vector<G4double> photon_energy = {1.54 * eV, 1.76 * eV, 2.06 * eV, 2.47 * eV, 2.75 * eV,
+                                         2.94 * eV, 3.09 * eV, 3.17 * eV, 3.25 * eV, 3.34 * eV,
+                                         3.43 * eV, 3.53 * eV, 3.64 * eV, 3.75 * eV, 3.86 * eV};
+  const G4int n_entries = photon_energy.size();
+  std::vector<G4double> reflectivity;
+
+  // Optical surface settings: Aerogel ↔ Teflon sheet
+  const auto &optics = gConfMan.GetConfig().optics;
+  const G4int teflon_layer = optics.teflon_layer;
+  const G4double SigmaAlpha = optics.sigma_alpha;
+  if (teflon_layer == 2)
+  {
+    reflectivity = {0.85, 0.90, 0.93, 0.97, 0.98,
+                    0.99, 0.99, 1.00, 1.00, 1.00,
+                    1.00, 1.00, 1.00, 1.00, 1.00};
+  }
+  else if (teflon_layer == 3)
+  {
+    reflectivity = {0.90, 0.93, 0.96, 0.98, 1.00,
+                    0.99, 0.99, 1.00, 1.00, 1.00,
+                    1.00, 1.00, 1.00, 1.00, 1.00};
+  }
+
+  auto gel_steflon_prop = new G4MaterialPropertiesTable();
+  gel_steflon_prop->AddProperty("REFLECTIVITY", &photon_energy[0], &reflectivity[0], n_entries);
+  gel_steflon_surf = new G4OpticalSurface("GelTeflonSheetSurface");
+  gel_steflon_surf->SetType(dielectric_dielectric);
+  gel_steflon_surf->SetModel(unified);
+  gel_steflon_surf->SetFinish(groundbackpainted);
+  gel_steflon_surf->SetSigmaAlpha(SigmaAlpha); // roughness
+  gel_steflon_surf->SetMaterialPropertiesTable(gel_steflon_prop);
+
+  // Optical surface settings: Aerogel ↔ Teflon frame
+  reflectivity = {0.97, 0.98, 0.99, 1.00, 1.00,
+                  0.99, 0.99, 1.00, 1.00, 1.00,
+                  1.00, 1.00, 1.00, 1.00, 1.00};
+
+  auto gel_fteflon_prop = new G4MaterialPropertiesTable();
+  gel_fteflon_prop->AddProperty("REFLECTIVITY", &photon_energy[0], &reflectivity[0], n_entries);
+  gel_fteflon_surf = new G4OpticalSurface("GelTeflonFrameSurface");
+  gel_fteflon_surf->SetType(dielectric_dielectric);
+  gel_fteflon_surf->SetModel(unified);
+  gel_fteflon_surf->SetFinish(groundfrontpainted);
+  gel_fteflon_surf->SetSigmaAlpha(SigmaAlpha); // roughness
+  gel_fteflon_surf->SetMaterialPropertiesTable(gel_fteflon_prop);
+}
+
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 void DetectorConstruction::ConstructSAC()
@@ -444,20 +483,20 @@ void DetectorConstruction::ConstructSAC()
   using CLHEP::deg;
   using CLHEP::mm;
 
+  const auto &geom = gConfMan.GetConfig().geometry;
   const G4ThreeVector gel_size(
-      gConfMan.GetDouble("gel_size_x") * mm,
-      gConfMan.GetDouble("gel_size_y") * mm,
-      gConfMan.GetDouble("gel_size_z") * mm);
-
-  const G4double teflon_thickness = gConfMan.GetDouble("teflon_thickness") * mm;
-  const G4double BlackSheet_thickness = gConfMan.GetDouble("BlackSheet_thickness") * mm;
-  const G4double frame_thickness = gConfMan.GetDouble("frame_thickness") * mm;
-  const G4double pmt_x_spacing = gConfMan.GetDouble("pmt_x_spacing") * mm;
-  const G4double pmt_y_spacing = gConfMan.GetDouble("pmt_y_spacing") * mm;
-  const G4double pmt_casing_radius = gConfMan.GetDouble("pmt_casing_radius") * mm;
-  const G4double pmt_window_radius = gConfMan.GetDouble("pmt_window_radius") * mm;
-  const G4double pmt_thickness = gConfMan.GetDouble("pmt_thickness") * mm;
-  const G4int pmt_channel = gConfMan.GetInt("pmt_channel");
+      geom.gel_size_x * mm,
+      geom.gel_size_y * mm,
+      geom.gel_size_z * mm);
+
+  const G4double teflon_thickness = geom.teflon_thickness * mm;
+  const G4double BlackSheet_thickness = geom.blacksheet_thickness * mm;
+  const G4double pmt_x_spacing = geom.pmt_x_spacing * mm;
+  const G4double pmt_y_spacing = geom.pmt_y_spacing * mm;
+  const G4double pmt_casing_radius = geom.pmt_casing_radius * mm;
+  const G4double pmt_window_radius = geom.pmt_window_radius * mm;
+  const G4double pmt_thickness = geom.pmt_thickness * mm;
+  const G4int pmt_channel = geom.pmt_channel;
   const G4ThreeVector origin(0, 0, 0);
 
   // ----------------------
@@ -472,6 +511,7 @@ void DetectorConstruction::ConstructSAC()
                                        "SACMotherLV");
   new G4PVPlacement(nullptr, origin, mother_lv, "SACMotherPV", m_world_lv, false, 0, m_check_overlaps);
   mother_lv->SetVisAttributes(G4VisAttributes::GetInvisible());
+  RegionCuts::AddRoot(RegionCuts::kAir, mother_lv);
 
   // ----------------------
   // Aerogel
@@ -480,6 +520,7 @@ void DetectorConstruction::ConstructSAC()
   auto gel_lv = new G4LogicalVolume(gel_solid, m_material_map["Aerogel"], "GelLV");
   auto gel_pv = new G4PVPlacement(nullptr, origin, gel_lv, "GelPV", mother_lv, false, 0, m_check_overlaps);
   // gel_lv->SetVisAttributes(G4Colour::Cyan());
+  RegionCuts::AddRoot(RegionCuts::kAerogel, gel_lv);
 
   // ----------------------
   // Teflon Sheet
@@ -491,6 +532,7 @@ void DetectorConstruction::ConstructSAC()
   auto sheet_top_pv = new G4PVPlacement(nullptr, sheet_pos_top, sheet_lv, "TeflonSheetTopPV", mother_lv, false, 0, m_check_overlaps);
   auto sheet_bot_pv = new G4PVPlacement(nullptr, sheet_pos_bot, sheet_lv, "TeflonSheetBotPV", mother_lv, false, 1, m_check_overlaps);
   sheet_lv->SetVisAttributes(G4Colour::White());
+  RegionCuts::AddRoot(RegionCuts::kPassive, sheet_lv);
   new G4LogicalBorderSurface("Gel_TeflonTop", gel_pv, sheet_top_pv, gel_steflon_surf);
   new G4LogicalBorderSurface("Gel_TeflonBot", gel_pv, sheet_bot_pv, gel_steflon_surf);
 
@@ -504,68 +546,25 @@ void DetectorConstruction::ConstructSAC()
   new G4PVPlacement(nullptr, black_top_pos, black_sheet_lv, "BlackSheetTopPV", mother_lv, false, 0, m_check_overlaps);
   new G4PVPlacement(nullptr, black_bot_pos, black_sheet_lv, "BlackSheetBotPV", mother_lv, false, 1, m_check_overlaps);
   black_sheet_lv->SetVisAttributes(G4Colour::Gray());
+  RegionCuts::AddRoot(RegionCuts::kPassive, black_sheet_lv);
 
   // ----------------------
   // Teflon Frame
   // ----------------------
-  auto frame_outer = new G4Box("FrameOuter", gel_size.x() / 2 + frame_thickness, gel_size.y() / 2 + frame_thickness, gel_size.z() / 2);
-  auto frame_inner = new G4Box("FrameInner", gel_size.x() / 2, gel_size.y() / 2, gel_size.z() / 2);
-  G4SubtractionSolid *frame = new G4SubtractionSolid("Frame", frame_outer, frame_inner);
-
-  // substract holes for PMTs
-  auto hole = new G4Tubs("hole", 0.0, pmt_casing_radius / 2, frame_thickness / 2, 0.0, 360.0 * deg);
+  for (const auto &part : FrameSolids::Build(geom, geom.frame_construction))
+  {
+    auto frame_lv = new G4LogicalVolume(part.solid, m_material_map["Teflon"], part.name + "LV");
+    auto frame_pv = new G4PVPlacement(nullptr, part.position, frame_lv, part.name + "PV", mother_lv, false, 0, m_check_overlaps);
+    frame_lv->SetVisAttributes(G4Colour::White());
+    RegionCuts::AddRoot(RegionCuts::kPassive, frame_lv);
+    new G4LogicalBorderSurface("Gel_" + part.name, gel_pv, frame_pv, gel_fteflon_surf);
+  }
 
   auto rotX = new G4RotationMatrix();
   rotX->rotateX(90. * deg);
   auto rotY = new G4RotationMatrix();
   rotY->rotateY(90. * deg);
 
-  // old SAC
-  if (pmt_channel == 8)
-  {
-    for (int i = 0; i < 3; ++i)
-    {
-      double x_pos = (i - 1) * pmt_x_spacing;
-      auto upper_trans = G4Transform3D(*rotX, G4ThreeVector(x_pos, gel_size.y() / 2 + frame_thickness / 2, 0));
-      auto lower_trans = G4Transform3D(*rotX, G4ThreeVector(x_pos, -gel_size.y() / 2 - frame_thickness / 2, 0));
-      frame = new G4SubtractionSolid("Frame", frame, hole, upper_trans);
-      frame = new G4SubtractionSolid("Frame", frame, hole, lower_trans);
-    }
-
-    double y_pos = 0;
-    auto left_trans = G4Transform3D(*rotY, G4ThreeVector(-gel_size.x() / 2 - frame_thickness / 2, y_pos, 0));
-    auto right_trans = G4Transform3D(*rotY, G4ThreeVector(gel_size.x() / 2 + frame_thickness / 2, y_pos, 0));
-    frame = new G4SubtractionSolid("Frame", frame, hole, left_trans);
-    frame = new G4SubtractionSolid("Frame", frame, hole, right_trans);
-  }
-
-  // new SAC
-  if (pmt_channel == 14)
-  {
-    for (int i = 0; i < 3; ++i)
-    {
-      double x_pos = (i - 1) * pmt_x_spacing;
-      auto upper_trans = G4Transform3D(*rotX, G4ThreeVector(x_pos, gel_size.y() / 2 + frame_thickness / 2, 0));
-      auto lower_trans = G4Transform3D(*rotX, G4ThreeVector(x_pos, -gel_size.y() / 2 - frame_thickness / 2, 0));
-      frame = new G4SubtractionSolid("Frame", frame, hole, upper_trans);
-      frame = new G4SubtractionSolid("Frame", frame, hole, lower_trans);
-    }
-
-    for (int i = 0; i < 4; ++i)
-    {
-      double y_pos = (1.5 - i) * pmt_y_spacing;
-      auto left_trans = G4Transform3D(*rotY, G4ThreeVector(-gel_size.x() / 2 - frame_thickness / 2, y_pos, 0));
-      auto right_trans = G4Transform3D(*rotY, G4ThreeVector(gel_size.x() / 2 + frame_thickness / 2, y_pos, 0));
-      frame = new G4SubtractionSolid("Frame", frame, hole, left_trans);
-      frame = new G4SubtractionSolid("Frame", frame, hole, right_trans);
-    }
-  }
-
-  auto frame_lv = new G4LogicalVolume(frame, m_material_map["Teflon"], "TeflonFrameLV");
-  auto frame_pv = new G4PVPlacement(nullptr, origin, frame_lv, "TeflonFramePV", mother_lv, false, 0, m_check_overlaps);
-  frame_lv->SetVisAttributes(G4Colour::White());
-  new G4LogicalBorderSurface("Gel_TeflonFrame", gel_pv, frame_pv, gel_fteflon_surf);
-
   // ----------------------
   // PMT (Window and Casing)
   // ----------------------
@@ -576,6 +575,9 @@ void DetectorConstruction::ConstructSAC()
   auto pmt_window_lv = new G4LogicalVolume(pmt_window_solid, m_material_map["Glass"], "PMTWindowLV");
 
   pmt_window_lv->SetVisAttributes(G4VisAttributes(G4Colour::Yellow()));
+  m_pmt_window_lv = pmt_window_lv;
+  RegionCuts::AddRoot(RegionCuts::kPassive, pmt_casing_lv);
+  RegionCuts::AddRoot(RegionCuts::kPMTWindow, pmt_window_lv);
 
   // old SAC
   if (pmt_channel == 8)
@@ -617,11 +619,6 @@ void DetectorConstruction::ConstructSAC()
       new G4PVPlacement(rotY, G4ThreeVector(gel_size.x() / 2 + pmt_thickness / 2, y_pos, 0), pmt_window_lv, "PMTWindow", mother_lv, false, i + 10, m_check_overlaps); // right window
     }
   }
-
-  // Set sensitive detector
-  auto pmt_sd = new PMTSD("PMT_SD");
-  G4SDManager::GetSDMpointer()->AddNewDetector(pmt_sd);
-  pmt_window_lv->SetSensitiveDetector(pmt_sd);
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
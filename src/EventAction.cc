@@ -1,26 +1,31 @@
 #include "EventAction.hh"
 #include "AnaManager.hh"
+#include "ConfManager.hh"
+#include "Instrumentation.hh"
+#include "ProgressReporter.hh"
+#include "StackingAction.hh"
 
-namespace
-{
-  auto& gAnaMan = AnaManager::GetInstance();
-}
-
-EventAction::EventAction() {
+EventAction::EventAction(AnaManager& anaMan, const StackingAction& stackingAction)
+  : fAnaMan(anaMan),
+    fStackingAction(stackingAction) {
 }
 
 EventAction::~EventAction() {
 }
 
 void EventAction::BeginOfEventAction(const G4Event* anEvent) {
-  gAnaMan.BeginOfEventAction(anEvent);
+  fAnaMan.BeginOfEventAction(anEvent);
+  Instrumentation::GetInstance().BeginOfEvent();
 }
 
 void EventAction::EndOfEventAction(const G4Event* anEvent) {
-  G4int eventID = anEvent->GetEventID();
-  gAnaMan.EndOfEventAction(anEvent);
+  // read before AnaManager hands the record over to the writer
+  const G4int detected = fAnaMan.GetNumOfDetectedPhotons();
+  Instrumentation::GetInstance().EndOfEvent(anEvent);
+  fAnaMan.EndOfEventAction(anEvent);
 
-  if (eventID % 100 == 0) {
-    G4cout << "   Event number = " << eventID << G4endl;
+  ProgressReporter::GetInstance().EndOfEvent(fStackingAction.GetNumOfTrackedPhotons(), detected);
+  if (ConfManager::GetInstance().GetConfig().general.verbose > 0 && anEvent->GetEventID() % 100 == 0) {
+    G4cout << "   Event number = " << anEvent->GetEventID() << G4endl;
   }
 }
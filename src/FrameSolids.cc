@@ -0,0 +1,129 @@
+#include "FrameSolids.hh"
+
+#include "G4Box.hh"
+#include "G4MultiUnion.hh"
+#include "G4RotationMatrix.hh"
+#include "G4SubtractionSolid.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4Transform3D.hh"
+#include "G4Tubs.hh"
+
+namespace
+{
+  // hole centres along x on the upper/lower walls and along y on the
+  // left/right walls
+  std::vector<G4double> HoleX(const GeometryConfig &geom)
+  {
+    const G4double spacing = geom.pmt_x_spacing * mm;
+    return {-spacing, 0., spacing};
+  }
+
+  std::vector<G4double> HoleY(const GeometryConfig &geom)
+  {
+    const G4double spacing = geom.pmt_y_spacing * mm;
+    if (geom.pmt_channel == 14)
+      return {1.5 * spacing, 0.5 * spacing, -0.5 * spacing, -1.5 * spacing};
+    return {0.};
+  }
+
+  G4RotationMatrix RotX()
+  {
+    G4RotationMatrix rot;
+    rot.rotateX(90. * deg);
+    return rot;
+  }
+
+  G4RotationMatrix RotY()
+  {
+    G4RotationMatrix rot;
+    rot.rotateY(90. * deg);
+    return rot;
+  }
+
+  G4VSolid *Hole(const GeometryConfig &geom)
+  {
+    return new G4Tubs("hole", 0.0, geom.pmt_casing_radius * mm / 2,
+                      geom.frame_thickness * mm / 2, 0.0, 360.0 * deg);
+  }
+
+  //___________________________________________________________________________
+  std::vector<FrameSolids::Part> BuildBoolean(const GeometryConfig &geom)
+  {
+    const G4double gel_x = geom.gel_size_x * mm;
+    const G4double gel_y = geom.gel_size_y * mm;
+    const G4double gel_z = geom.gel_size_z * mm;
+    const G4double thickness = geom.frame_thickness * mm;
+
+    auto frame_outer = new G4Box("FrameOuter", gel_x / 2 + thickness, gel_y / 2 + thickness, gel_z / 2);
+    auto frame_inner = new G4Box("FrameInner", gel_x / 2, gel_y / 2, gel_z / 2);
+    G4VSolid *frame = new G4SubtractionSolid("Frame", frame_outer, frame_inner);
+
+    auto hole = Hole(geom);
+    const auto rotX = RotX();
+    const auto rotY = RotY();
+    for (const G4double x : HoleX(geom))
+    {
+      frame = new G4SubtractionSolid("Frame", frame, hole, G4Transform3D(rotX, G4ThreeVector(x, gel_y / 2 + thickness / 2, 0)));
+      frame = new G4SubtractionSolid("Frame", frame, hole, G4Transform3D(rotX, G4ThreeVector(x, -gel_y / 2 - thickness / 2, 0)));
+    }
+    for (const G4double y : HoleY(geom))
+    {
+      frame = new G4SubtractionSolid("Frame", frame, hole, G4Transform3D(rotY, G4ThreeVector(-gel_x / 2 - thickness / 2, y, 0)));
+      frame = new G4SubtractionSolid("Frame", frame, hole, G4Transform3D(rotY, G4ThreeVector(gel_x / 2 + thickness / 2, y, 0)));
+    }
+    return {{"TeflonFrame", frame, G4ThreeVector()}};
+  }
+
+  //___________________________________________________________________________
+  // One wall: a box minus a single G4MultiUnion of its holes, so a navigation
+  // call costs one box, one voxelised union and only the nearby holes.
+  G4VSolid *Wall(const G4String &name, G4double half_x, G4double half_y, G4double half_z,
+                 G4VSolid *hole, const std::vector<G4ThreeVector> &holes, const G4RotationMatrix &rot)
+  {
+    auto box = new G4Box(name + "Box", half_x, half_y, half_z);
+    auto union_of_holes = new G4MultiUnion(name + "Holes");
+    for (const auto &position : holes)
+      union_of_holes->AddNode(*hole, G4Transform3D(rot, position));
+    union_of_holes->Voxelize();
+    return new G4SubtractionSolid(name, box, union_of_holes);
+  }
+
+  //___________________________________________________________________________
+  // The upper and lower walls run over the full outer width and include the
+  // corners, the left and right walls only cover the gel height.
+  std::vector<FrameSolids::Part> BuildSegments(const GeometryConfig &geom)
+  {
+    const G4double gel_x = geom.gel_size_x * mm;
+    const G4double gel_y = geom.gel_size_y * mm;
+    const G4double gel_z = geom.gel_size_z * mm;
+    const G4double thickness = geom.frame_thickness * mm;
+
+    auto hole = Hole(geom);
+
+    std::vector<G4ThreeVector> x_holes;
+    for (const G4double x : HoleX(geom))
+      x_holes.emplace_back(x, 0, 0);
+    auto x_wall = Wall("FrameWallX", gel_x / 2 + thickness, thickness / 2, gel_z / 2, hole, x_holes, RotX());
+
+    std::vector<G4ThreeVector> y_holes;
+    for (const G4double y : HoleY(geom))
+      y_holes.emplace_back(0, y, 0);
+    auto y_wall = Wall("FrameWallY", thickness / 2, gel_y / 2, gel_z / 2, hole, y_holes, RotY());
+
+    return {
+        {"TeflonFrameTop", x_wall, G4ThreeVector(0, gel_y / 2 + thickness / 2, 0)},
+        {"TeflonFrameBot", x_wall, G4ThreeVector(0, -gel_y / 2 - thickness / 2, 0)},
+        {"TeflonFrameLeft", y_wall, G4ThreeVector(-gel_x / 2 - thickness / 2, 0, 0)},
+        {"TeflonFrameRight", y_wall, G4ThreeVector(gel_x / 2 + thickness / 2, 0, 0)},
+    };
+  }
+}
+
+//_____________________________________________________________________________
+std::vector<FrameSolids::Part> FrameSolids::Build(const GeometryConfig &geom,
+                                                  GeometryConfig::FrameConstruction construction)
+{
+  if (construction == GeometryConfig::FrameSegments)
+    return BuildSegments(geom);
+  return BuildBoolean(geom);
+}
@@ -0,0 +1,155 @@
+#include "GeometryBenchmark.hh"
+#include "ConfManager.hh"
+#include "FrameSolids.hh"
+
+#include "G4Box.hh"
+#include "G4GeometryTolerance.hh"
+#include "G4LogicalVolume.hh"
+#include "G4Navigator.hh"
+#include "G4PVPlacement.hh"
+#include "G4SmartVoxelHeader.hh"
+#include "G4SolidStore.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4ios.hh"
+#include "voxeldefs.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace
+{
+  using Clock = std::chrono::steady_clock;
+
+  struct Sample
+  {
+    G4ThreeVector position;
+    G4ThreeVector direction;
+  };
+
+  struct Result
+  {
+    G4double ns_per_step = 0.;
+    std::vector<char> in_frame;
+    std::vector<G4double> step;
+  };
+
+  //___________________________________________________________________________
+  // The frame parts alone in an empty world, voxelised like
+  // G4GeometryManager::CloseGeometry would. Materials are not needed to
+  // navigate and are left out, so the material table is not touched.
+  Result Measure(const std::vector<FrameSolids::Part> &parts, const G4ThreeVector &world_half,
+                 const std::vector<Sample> &samples)
+  {
+    auto world_solid = new G4Box("BenchWorldSolid", world_half.x(), world_half.y(), world_half.z());
+    auto world_lv = new G4LogicalVolume(world_solid, nullptr, "BenchWorldLV");
+    auto world_pv = new G4PVPlacement(nullptr, G4ThreeVector(), world_lv, "BenchWorldPV", nullptr, false, 0);
+
+    std::vector<G4LogicalVolume *> part_lvs;
+    std::vector<G4VPhysicalVolume *> part_pvs;
+    for (const auto &part : parts)
+    {
+      part_lvs.push_back(new G4LogicalVolume(part.solid, nullptr, "Bench" + part.name + "LV"));
+      part_pvs.push_back(new G4PVPlacement(nullptr, part.position, part_lvs.back(), "Bench" + part.name + "PV",
+                                           world_lv, false, 0));
+    }
+    if (world_lv->GetNoDaughters() >= kMinVoxelVolumesLevel1)
+      world_lv->SetVoxelHeader(new G4SmartVoxelHeader(world_lv));
+
+    G4Navigator navigator;
+    navigator.SetWorldVolume(world_pv);
+
+    Result result;
+    result.in_frame.reserve(samples.size());
+    result.step.reserve(samples.size());
+    G4double safety = 0.;
+
+    // warm up the caches, then time
+    for (std::size_t i = 0; i < std::min<std::size_t>(samples.size(), 1000); ++i)
+    {
+      navigator.LocateGlobalPointAndSetup(samples[i].position, &samples[i].direction, false, false);
+      navigator.ComputeStep(samples[i].position, samples[i].direction, kInfinity, safety);
+    }
+    const auto start = Clock::now();
+    for (const auto &sample : samples)
+    {
+      auto pv = navigator.LocateGlobalPointAndSetup(sample.position, &sample.direction, false, false);
+      result.in_frame.push_back(pv != world_pv);
+      result.step.push_back(navigator.ComputeStep(sample.position, sample.direction, kInfinity, safety));
+    }
+    const G4double seconds = std::chrono::duration<G4double>(Clock::now() - start).count();
+    result.ns_per_step = samples.empty() ? 0. : seconds * 1e9 / samples.size();
+
+    delete world_lv->GetVoxelHeader();
+    world_lv->SetVoxelHeader(nullptr);
+    for (auto pv : part_pvs)
+      delete pv;
+    for (auto lv : part_lvs)
+      delete lv;
+    delete world_pv;
+    delete world_lv;
+    return result;
+  }
+}
+
+//_____________________________________________________________________________
+void GeometryBenchmark::Frame(G4int npoints)
+{
+  const auto &geom = ConfManager::GetInstance().GetConfig().geometry;
+  const G4double thickness = geom.frame_thickness * mm;
+
+  // points in the frame, its holes, the cavity of the gel and a frame
+  // thickness of air around it
+  const G4ThreeVector sample_half(geom.gel_size_x * mm / 2 + 2 * thickness,
+                                  geom.gel_size_y * mm / 2 + 2 * thickness,
+                                  geom.gel_size_z * mm / 2 + thickness);
+  const G4ThreeVector world_half = sample_half + G4ThreeVector(10 * mm, 10 * mm, 10 * mm);
+
+  // fixed seed, the global engine is left alone
+  std::mt19937_64 engine(12345);
+  std::uniform_real_distribution<G4double> flat(0., 1.);
+  std::vector<Sample> samples(npoints);
+  for (auto &sample : samples)
+  {
+    sample.position.set((2 * flat(engine) - 1) * sample_half.x(),
+                        (2 * flat(engine) - 1) * sample_half.y(),
+                        (2 * flat(engine) - 1) * sample_half.z());
+    const G4double cos_theta = 2 * flat(engine) - 1;
+    const G4double sin_theta = std::sqrt(1 - cos_theta * cos_theta);
+    const G4double phi = twopi * flat(engine);
+    sample.direction.set(sin_theta * std::cos(phi), sin_theta * std::sin(phi), cos_theta);
+  }
+
+  // the test solids are deleted again, they are the ones added to the store
+  auto solid_store = G4SolidStore::GetInstance();
+  const std::size_t nsolids = solid_store->size();
+  const Result boolean = Measure(FrameSolids::Build(geom, GeometryConfig::FrameBoolean), world_half, samples);
+  const Result segments = Measure(FrameSolids::Build(geom, GeometryConfig::FrameSegments), world_half, samples);
+  while (solid_store->size() > nsolids)
+    delete solid_store->back();
+
+  // Inside the frame the segments stop at the joints between walls, so the
+  // distances are only compared from outside.
+  const G4double tolerance = G4GeometryTolerance::GetInstance()->GetSurfaceTolerance();
+  G4int nin = 0, nlocate_diff = 0, nstep_diff = 0;
+  for (std::size_t i = 0; i < samples.size(); ++i)
+  {
+    nin += boolean.in_frame[i];
+    if (boolean.in_frame[i] != segments.in_frame[i])
+      ++nlocate_diff;
+    else if (!boolean.in_frame[i] && std::abs(boolean.step[i] - segments.step[i]) > tolerance)
+      ++nstep_diff;
+  }
+
+  G4cout << "=== Frame navigation benchmark: " << npoints << " points, "
+         << (npoints > 0 ? 100. * nin / npoints : 0.) << "% in the frame ===" << G4endl
+         << "   boolean  : " << boolean.ns_per_step << " ns/step" << G4endl
+         << "   segments : " << segments.ns_per_step << " ns/step";
+  if (segments.ns_per_step > 0.)
+    G4cout << ", " << boolean.ns_per_step / segments.ns_per_step << "x faster";
+  G4cout << G4endl
+         << "   differences: " << nlocate_diff << " located volumes, "
+         << nstep_diff << " step lengths from outside" << G4endl;
+}
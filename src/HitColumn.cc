@@ -0,0 +1,68 @@
+#include "HitColumn.hh"
+
+#include "TBranch.h"
+#include "TString.h"
+#include "TTree.h"
+
+//_____________________________________________________________________________
+HitColumn::HitColumn()
+    : m_type(ColumnPrecision::Double),
+      m_source(nullptr),
+      m_branch(nullptr)
+{
+}
+
+//_____________________________________________________________________________
+void HitColumn::Branch(TTree *tree, const char *name, const char *count,
+                       std::vector<G4double> &source, const ColumnPrecision &precision,
+                       G4int basket_size)
+{
+  m_type = precision.type;
+  m_source = &source;
+  // the leaflist branches must never see a null address
+  m_float.reserve(64);
+  m_double.reserve(64);
+
+  TString range;
+  if (precision.nbits > 0)
+    range.Form("[%g,%g,%d]", precision.min, precision.max, precision.nbits);
+
+  switch (m_type)
+  {
+  case ColumnPrecision::Double:
+    m_branch = tree->Branch(name, m_source, basket_size);
+    break;
+  case ColumnPrecision::Float:
+    m_branch = tree->Branch(name, &m_float, basket_size);
+    break;
+  case ColumnPrecision::Float16:
+    m_branch = tree->Branch(name, m_float.data(),
+                            Form("%s[%s]/f%s", name, count, range.Data()), basket_size);
+    break;
+  case ColumnPrecision::Double32:
+    m_branch = tree->Branch(name, m_double.data(),
+                            Form("%s[%s]/d%s", name, count, range.Data()), basket_size);
+    break;
+  }
+}
+
+//_____________________________________________________________________________
+void HitColumn::Stage()
+{
+  switch (m_type)
+  {
+  case ColumnPrecision::Double:
+    break;
+  case ColumnPrecision::Float:
+    m_float.assign(m_source->begin(), m_source->end());
+    break;
+  case ColumnPrecision::Float16:
+    m_float.assign(m_source->begin(), m_source->end());
+    m_branch->SetAddress(m_float.data());
+    break;
+  case ColumnPrecision::Double32:
+    m_double.assign(m_source->begin(), m_source->end());
+    m_branch->SetAddress(m_double.data());
+    break;
+  }
+}
@@ -0,0 +1,227 @@
+#include "Instrumentation.hh"
+#include "ConfManager.hh"
+#include "JobRunManager.hh"
+#include "SACOpBoundaryProcess.hh"
+
+#include "G4Event.hh"
+#include "G4LogicalVolume.hh"
+#include "G4LogicalVolumeStore.hh"
+#include "G4OpticalPhoton.hh"
+#include "G4ParticleTable.hh"
+#include "G4Step.hh"
+#include "G4VPhysicalVolume.hh"
+
+#include "TFile.h"
+#include "TH1D.h"
+#include "TTree.h"
+
+#include <string>
+
+namespace
+{
+  std::string StatusName(G4int status)
+  {
+    switch (status)
+    {
+    case Undefined:
+      return "Undefined";
+    case Transmission:
+      return "Transmission";
+    case FresnelRefraction:
+      return "FresnelRefraction";
+    case FresnelReflection:
+      return "FresnelReflection";
+    case TotalInternalReflection:
+      return "TotalInternalReflection";
+    case LambertianReflection:
+      return "LambertianReflection";
+    case LobeReflection:
+      return "LobeReflection";
+    case SpikeReflection:
+      return "SpikeReflection";
+    case BackScattering:
+      return "BackScattering";
+    case Absorption:
+      return "Absorption";
+    case Detection:
+      return "Detection";
+    case NotAtBoundary:
+      return "NotAtBoundary";
+    case SameMaterial:
+      return "SameMaterial";
+    case StepTooSmall:
+      return "StepTooSmall";
+    case NoRINDEX:
+      return "NoRINDEX";
+    default:
+      return "status " + std::to_string(status);
+    }
+  }
+
+  // one labelled bin per non-zero count
+  template <typename NameOf>
+  void WriteCounts(const char *name, const char *title, const std::vector<G4long> &counts, NameOf name_of)
+  {
+    TH1D histogram(name, title, 1, 0., 1.);
+    histogram.SetDirectory(nullptr);
+    histogram.SetCanExtend(TH1::kAllAxes);
+    for (std::size_t i = 0; i < counts.size(); ++i)
+    {
+      if (counts[i] > 0)
+        histogram.Fill(name_of(static_cast<G4int>(i)).c_str(), static_cast<G4double>(counts[i]));
+    }
+    histogram.LabelsDeflate();
+    histogram.Write(); // into the current directory, the output file
+  }
+}
+
+//_____________________________________________________________________________
+Instrumentation &Instrumentation::GetInstance()
+{
+  static G4ThreadLocal Instrumentation *instance = nullptr;
+  if (!instance)
+    instance = new Instrumentation;
+  return *instance;
+}
+
+//_____________________________________________________________________________
+Instrumentation::Instrumentation()
+    : m_enabled(false),
+      m_boundary(nullptr),
+      m_current()
+{
+}
+
+//_____________________________________________________________________________
+void Instrumentation::BeginOfRun()
+{
+  m_enabled = ConfManager::GetInstance().GetConfig().general.instrumentation;
+  m_boundary = SACOpBoundaryProcess::GetForThisThread();
+  m_rows.clear();
+  m_steps_by_volume.clear();
+  m_steps_by_particle.clear();
+  m_boundaries_by_volume.clear();
+  m_boundaries_by_status.clear();
+}
+
+//_____________________________________________________________________________
+void Instrumentation::EndOfRun(TFile *file)
+{
+  if (!m_enabled || !file)
+    return;
+  file->cd();
+  WriteTree();
+  WriteHistograms();
+  m_rows.clear();
+}
+
+//_____________________________________________________________________________
+void Instrumentation::BeginOfEvent()
+{
+  if (!m_enabled)
+    return;
+  m_current = Row();
+  m_event_start = Clock::now();
+}
+
+//_____________________________________________________________________________
+void Instrumentation::EndOfEvent(const G4Event *event)
+{
+  if (!m_enabled)
+    return;
+  m_current.wall_time = std::chrono::duration<G4double>(Clock::now() - m_event_start).count();
+  m_current.evnum = event->GetEventID() + JobRunManager::GetEventOffset();
+  m_rows.push_back(m_current);
+}
+
+//_____________________________________________________________________________
+void Instrumentation::Count(std::vector<G4long> &counts, G4int index)
+{
+  if (index < 0)
+    return;
+  if (index >= static_cast<G4int>(counts.size()))
+    counts.resize(index + 1, 0);
+  ++counts[index];
+}
+
+//_____________________________________________________________________________
+void Instrumentation::Step(const G4Step *step)
+{
+  ++m_current.steps;
+  const G4StepPoint *pre = step->GetPreStepPoint();
+  const G4StepPoint *post = step->GetPostStepPoint();
+  Count(m_steps_by_volume, pre->GetPhysicalVolume()->GetLogicalVolume()->GetInstanceID());
+  const G4ParticleDefinition *particle = step->GetTrack()->GetDefinition();
+  Count(m_steps_by_particle, particle->GetParticleDefinitionID());
+
+  if (particle != G4OpticalPhoton::Definition())
+    return;
+  ++m_current.optical_steps;
+  if (post->GetStepStatus() != fGeomBoundary || !post->GetPhysicalVolume())
+    return;
+  ++m_current.optical_boundaries;
+  Count(m_boundaries_by_volume, post->GetPhysicalVolume()->GetLogicalVolume()->GetInstanceID());
+  if (m_boundary)
+    Count(m_boundaries_by_status, m_boundary->GetStatus());
+}
+
+//_____________________________________________________________________________
+// into the current directory, the output file
+void Instrumentation::WriteTree() const
+{
+  Row row;
+  TTree tree("instrumentation", "tracking instrumentation per event");
+  tree.Branch("evnum", &row.evnum, "evnum/I");
+  tree.Branch("wall_time", &row.wall_time, "wall_time/D");
+  tree.Branch("steps", &row.steps, "steps/L");
+  tree.Branch("optical_steps", &row.optical_steps, "optical_steps/L");
+  tree.Branch("optical_boundaries", &row.optical_boundaries, "optical_boundaries/L");
+  for (const Row &r : m_rows)
+  {
+    row = r;
+    tree.Fill();
+  }
+  tree.Write();
+}
+
+//_____________________________________________________________________________
+void Instrumentation::WriteHistograms() const
+{
+  // instance IDs are only unique among the existing volumes, the geometry
+  // cannot change during a run
+  std::vector<std::string> volume_names;
+  for (const G4LogicalVolume *lv : *G4LogicalVolumeStore::GetInstance())
+  {
+    const G4int id = lv->GetInstanceID();
+    if (id >= static_cast<G4int>(volume_names.size()))
+      volume_names.resize(id + 1);
+    volume_names[id] = lv->GetName();
+  }
+  std::vector<std::string> particle_names;
+  auto iterator = G4ParticleTable::GetParticleTable()->GetIterator();
+  iterator->reset();
+  while ((*iterator)())
+  {
+    const G4int id = iterator->value()->GetParticleDefinitionID();
+    if (id < 0)
+      continue;
+    if (id >= static_cast<G4int>(particle_names.size()))
+      particle_names.resize(id + 1);
+    particle_names[id] = iterator->value()->GetParticleName();
+  }
+
+  auto name_of = [](const std::vector<std::string> &names, const char *kind, G4int id)
+  {
+    return id < static_cast<G4int>(names.size()) && !names[id].empty() ? names[id]
+                                                                       : kind + std::to_string(id);
+  };
+  auto volume_name = [&](G4int id) { return name_of(volume_names, "volume ", id); };
+  auto particle_name = [&](G4int id) { return name_of(particle_names, "particle ", id); };
+
+  WriteCounts("steps_by_volume", "steps per logical volume", m_steps_by_volume, volume_name);
+  WriteCounts("steps_by_particle", "steps per particle", m_steps_by_particle, particle_name);
+  WriteCounts("optical_boundaries_by_volume", "optical photon boundary steps per volume entered",
+              m_boundaries_by_volume, volume_name);
+  WriteCounts("optical_boundary_status", "optical photon boundary steps per boundary status",
+              m_boundaries_by_status, StatusName);
+}
@@ -0,0 +1,104 @@
+#include "JobRunManager.hh"
+#include "AnaManager.hh"
+
+#include "G4ios.hh"
+
+#include <cstdio>
+#include <string>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+std::uint64_t JobRunManager::fBaseSeed = 0;
+G4int JobRunManager::fJobIndex = 0;
+G4long JobRunManager::fEventOffset = 0;
+long JobRunManager::fRunSeed = 0;
+G4bool JobRunManager::fReplay = false;
+
+//_____________________________________________________________________________
+void JobRunManager::SetReplay(long run_seed, G4long event_id)
+{
+  fReplay = true;
+  fRunSeed = run_seed;
+  fEventOffset = event_id;
+}
+
+//_____________________________________________________________________________
+JobRunManager::JobRunManager(G4int njobs)
+    : G4RunManager(),
+      fNJobs(njobs)
+{
+}
+
+//_____________________________________________________________________________
+JobRunManager::~JobRunManager()
+{
+}
+
+//_____________________________________________________________________________
+void JobRunManager::BeamOn(G4int n_event, const char *macroFile, G4int n_select)
+{
+  if (fNJobs <= 1 || n_event <= 0)
+  {
+    G4RunManager::BeamOn(n_event, macroFile, n_select);
+    return;
+  }
+
+  // geometry and physics tables are built once here and shared by the jobs
+  G4RunManager::BeamOn(0);
+
+  const G4String output = AnaManager::GetOutputRootfilePath();
+  std::vector<G4String> parts;
+  std::vector<pid_t> pids;
+  G4long first = 0;
+  G4cout << std::flush;
+  std::fflush(nullptr);
+  for (G4int job = 0; job < fNJobs; ++job)
+  {
+    const G4int nevents = n_event / fNJobs + (job < n_event % fNJobs ? 1 : 0);
+    const G4String part = AnaManager::GetPartFilePath("j" + std::to_string(job));
+    parts.push_back(part);
+
+    const pid_t pid = fork();
+    if (pid == 0)
+    {
+      fJobIndex = job;
+      fEventOffset = first;
+      AnaManager::SetOutputRootfilePath(part);
+      G4RunManager::BeamOn(nevents, macroFile, n_select);
+      G4cout << std::flush;
+      std::fflush(nullptr);
+      // the parent owns everything else, leave without destructors
+      _exit(0);
+    }
+    if (pid < 0)
+    {
+      G4cerr << "[JobRunManager] Error: fork failed for job " << job << G4endl;
+      break;
+    }
+    pids.push_back(pid);
+    first += nevents;
+  }
+
+  // the runs happened in the children, keep the run IDs (and seeds) of the
+  // next beamOn distinct
+  ++runIDCounter;
+
+  G4bool ok = pids.size() == static_cast<std::size_t>(fNJobs);
+  for (std::size_t job = 0; job < pids.size(); ++job)
+  {
+    int status = 0;
+    if (waitpid(pids[job], &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+    {
+      G4cerr << "[JobRunManager] Error: job " << job << " failed" << G4endl;
+      ok = false;
+    }
+  }
+  if (!ok)
+  {
+    G4cerr << "[JobRunManager] Error: not merging, job files are kept" << G4endl;
+    return;
+  }
+  AnaManager::MergePartFiles(parts);
+  G4cout << "   Merged " << fNJobs << " jobs into " << output << G4endl;
+}
@@ -0,0 +1,87 @@
+#include "OpticalPhysicsList.hh"
+
+#include "G4DecayPhysics.hh"
+#include "G4EmStandardPhysics.hh"
+#include "G4EmStandardPhysics_option1.hh"
+#include "G4EmStandardPhysics_option2.hh"
+#include "G4EmStandardPhysics_option3.hh"
+#include "G4EmStandardPhysics_option4.hh"
+#include "G4Cerenkov.hh"
+#include "G4OpBoundaryProcess.hh"
+#include "G4OpticalPhoton.hh"
+#include "G4ParticleTable.hh"
+#include "G4ProcessManager.hh"
+#include "SACCerenkov.hh"
+#include "SACOpBoundaryProcess.hh"
+
+#include <set>
+
+//_____________________________________________________________________________
+G4VPhysicsConstructor *CreateEmPhysics(G4int em_option)
+{
+  switch (em_option)
+  {
+  case 0:
+    return new G4EmStandardPhysics();
+  case 1:
+    return new G4EmStandardPhysics_option1();
+  case 2:
+    return new G4EmStandardPhysics_option2();
+  case 3:
+    return new G4EmStandardPhysics_option3();
+  default:
+    return new G4EmStandardPhysics_option4();
+  }
+}
+
+//_____________________________________________________________________________
+OpticalPhysicsList::OpticalPhysicsList(G4int em_option, G4bool decay)
+    : G4VModularPhysicsList()
+{
+  RegisterPhysics(CreateEmPhysics(em_option));
+  if (decay)
+    RegisterPhysics(new G4DecayPhysics());
+  RegisterPhysics(new SACOpticalPhysics());
+}
+
+//_____________________________________________________________________________
+OpticalPhysicsList::~OpticalPhysicsList()
+{
+}
+
+//_____________________________________________________________________________
+void SACOpticalPhysics::ConstructProcess()
+{
+  G4OpticalPhysics::ConstructProcess();
+
+  auto manager = G4OpticalPhoton::Definition()->GetProcessManager();
+  auto stock = dynamic_cast<G4OpBoundaryProcess *>(manager->GetProcess("OpBoundary"));
+  if (stock)
+  {
+    manager->RemoveProcess(stock);
+    manager->AddDiscreteProcess(new SACOpBoundaryProcess(stock));
+  }
+
+  // G4OpticalPhysics shares one G4Cerenkov between all charged particles
+  std::set<G4Cerenkov *> stock_cerenkov;
+  SACCerenkov *cerenkov = nullptr;
+  auto iterator = G4ParticleTable::GetParticleTable()->GetIterator();
+  iterator->reset();
+  while ((*iterator)())
+  {
+    auto particle_manager = iterator->value()->GetProcessManager();
+    if (!particle_manager)
+      continue;
+    auto process = dynamic_cast<G4Cerenkov *>(particle_manager->GetProcess("Cerenkov"));
+    if (!process || process == cerenkov)
+      continue;
+    if (!cerenkov)
+      cerenkov = new SACCerenkov();
+    stock_cerenkov.insert(process);
+    particle_manager->RemoveProcess(process);
+    particle_manager->AddProcess(cerenkov);
+    particle_manager->SetProcessOrdering(cerenkov, idxPostStep);
+  }
+  for (auto process : stock_cerenkov)
+    delete process;
+}
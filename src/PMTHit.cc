@@ -1,44 +0,0 @@
-#include "PMTHit.hh"
-
-#include "G4SystemOfUnits.hh"
-#include "G4UnitsTable.hh"
-#include "G4ios.hh"
-
-G4Allocator<PMTHit> PMTHitAllocator;
-
-PMTHit::PMTHit()
-    : fPosition(G4ThreeVector()),
-      fWorldPosition(G4ThreeVector()),
-      fTime(0.),
-      fEnergy(0.),
-      fWaveLength(0.),
-      fParticleID(0),
-      fCopyNumber(0),
-      fEventID(0),
-      fDetectFlag(0)
-{
-}
-
-PMTHit::~PMTHit() {}
-
-PMTHit::PMTHit(const PMTHit &right) : G4VHit()
-{
-    fPosition = right.fPosition;
-    fWorldPosition = right.fWorldPosition;
-    fTime = right.fTime;
-    fEnergy = right.fEnergy;
-    fWaveLength = right.fWaveLength;
-    fParticleID = right.fParticleID;
-    fCopyNumber = right.fCopyNumber;
-    fEventID = right.fEventID;
-    fDetectFlag = right.fDetectFlag;
-}
-
-void PMTHit::Print() const
-{
-    G4cout << "PMTHit: Position = " << fPosition
-           << ", Time = " << G4BestUnit(fTime, "Time")
-           << ", Energy = " << G4BestUnit(fEnergy, "Energy")
-           << ", EventID = " << fEventID
-           << G4endl;
-}
@@ -1,39 +1,49 @@
 // Reference: https://kumaroot.readthedocs.io/ja/latest/geant4/geant4-qe.html
 
 #include "PMTSD.hh"
-#include "PMTHit.hh"
 
-#include "G4SDManager.hh"
 #include "G4Step.hh"
 #include "G4Track.hh"
 #include "G4OpticalPhoton.hh"
-#include "G4HCofThisEvent.hh"
-#include "G4EventManager.hh"
 #include "Randomize.hh"
+#include "AnaManager.hh"
+#include "ConfManager.hh"
 
 #include "TGraph.h"
 #include "TSpline.h"
 
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+  // number of points of the efficiency table and the largest deviation
+  // from the spline product allowed anywhere in the sensitive range
+  const std::size_t kEffTableSize = 4096;
+  const G4double kEffTolerance = 1.0e-5;
+}
+
 PMTSD::PMTSD(const G4String &name)
     : G4VSensitiveDetector(name),
-      m_qe_spline(nullptr),
-      m_trans_spline(nullptr)
+      m_ana_man(AnaManager::GetInstance()),
+      m_eff_emin(0.),
+      m_eff_emax(0.),
+      m_eff_inv_step(0.),
+      m_eff_max(0.),
+      m_qe_culling(ConfManager::GetInstance().GetConfig().optics.qe_culling)
 {
-  collectionName.insert("PmtCollection");
   InitializeQESplines();
 }
 
 PMTSD::~PMTSD()
 {
-  delete m_qe_spline;
-  delete m_trans_spline;
 }
 
 //_____________________________________________________________________________
-void PMTSD::Initialize(G4HCofThisEvent *HCTE)
+// The SD outlives configuration changes between runs, see SACMessenger.
+void PMTSD::Initialize(G4HCofThisEvent *)
 {
-  m_hits_collection = new G4THitsCollection<PMTHit>(SensitiveDetectorName, collectionName[0]);
-  HCTE->AddHitsCollection(GetCollectionID(0), m_hits_collection);
+  m_qe_culling = ConfManager::GetInstance().GetConfig().optics.qe_culling;
 }
 
 //_____________________________________________________________________________
@@ -51,13 +61,10 @@ G4bool PMTSD::ProcessHits(G4Step *aStep, G4TouchableHistory *)
   // Energy
   G4double energy = aTrack->GetKineticEnergy(); // exclude rest mass
 
-  // Calculate the effective Quantum Efficiency
-  G4double eff_qe = 0.0;
-  if (energy >= m_qe_spline->GetXmin() && energy <= m_qe_spline->GetXmax() &&
-      energy >= m_trans_spline->GetXmin() && energy <= m_trans_spline->GetXmax())
-  {
-    eff_qe = m_qe_spline->Eval(energy) * m_trans_spline->Eval(energy);
-  }
+  // Calculate the effective Quantum Efficiency. With QE culling the photon
+  // survived its birth with probability eff(E)/eff_max, so the detection
+  // probability left to apply is eff_max.
+  G4double eff_qe = m_qe_culling ? m_eff_max : GetEfficiency(energy);
 
   // Detection flag
   G4int detectFlag = 0;
@@ -73,28 +80,12 @@ G4bool PMTSD::ProcessHits(G4Step *aStep, G4TouchableHistory *)
   G4double hitTime = preStepPoint->GetGlobalTime();
   G4double waveLength = (CLHEP::h_Planck * CLHEP::c_light / energy) / CLHEP::nm;
   G4int copyNumber = preStepPoint->GetTouchableHandle()->GetCopyNumber();
-  G4int eventID = G4EventManager::GetEventManager()->GetConstCurrentEvent()->GetEventID();
   G4int particleID = aTrack->GetDefinition()->GetPDGEncoding();
 
-  // Create hit
-  auto *aHit = new PMTHit();
-  aHit->SetPosition(pos);
-  aHit->SetWorldPosition(worldPos);
-  aHit->SetEnergy(energy);
-  aHit->SetWaveLength(waveLength);
-  aHit->SetTime(hitTime);
-  aHit->SetCopyNumber(copyNumber);
-  aHit->SetEventID(eventID);
-  aHit->SetDetectFlag(detectFlag);
-  aHit->SetParticleID(particleID);
-
-  m_hits_collection->insert(aHit);
+  m_ana_man.AddPMTHit(pos, hitTime, energy, waveLength, particleID, copyNumber, detectFlag);
   return true;
 }
 
-//_____________________________________________________________________________
-void PMTSD::EndOfEvent(G4HCofThisEvent *) {}
-
 //_____________________________________________________________________________
 void PMTSD::InitializeQESplines()
 {
@@ -148,9 +139,40 @@ void PMTSD::InitializeQESplines()
   auto *qe_graph = new TGraph(photonEnergyQE.size(), &photonEnergyQE[0], &QE[0]);
   auto *t_graph = new TGraph(photonEnergyT.size(), &photonEnergyT[0], &Trans[0]);
 
-  m_qe_spline = new TSpline3("qe_spline", qe_graph);
-  m_trans_spline = new TSpline3("trans_spline", t_graph);
+  TSpline3 qe_spline("qe_spline", qe_graph);
+  TSpline3 trans_spline("trans_spline", t_graph);
 
   delete qe_graph;
   delete t_graph;
+
+  // ---- Bake QE x transmittance ----
+  // zero outside the range where both curves are defined
+  m_eff_emin = std::max(qe_spline.GetXmin(), trans_spline.GetXmin());
+  m_eff_emax = std::min(qe_spline.GetXmax(), trans_spline.GetXmax());
+  const G4double step = (m_eff_emax - m_eff_emin) / (kEffTableSize - 1);
+  m_eff_inv_step = 1. / step;
+
+  m_eff_table.resize(kEffTableSize);
+  for (std::size_t i = 0; i < kEffTableSize; ++i)
+  {
+    const G4double e = std::min(m_eff_emin + i * step, m_eff_emax);
+    m_eff_table[i] = qe_spline.Eval(e) * trans_spline.Eval(e);
+  }
+  m_eff_max = *std::max_element(m_eff_table.begin(), m_eff_table.end());
+
+  // linear interpolation is worst half way between two nodes
+  G4double max_dev = 0.;
+  for (std::size_t i = 0; i + 1 < kEffTableSize; ++i)
+  {
+    const G4double e = m_eff_emin + (i + 0.5) * step;
+    const G4double dev = std::abs(GetEfficiency(e) - qe_spline.Eval(e) * trans_spline.Eval(e));
+    max_dev = std::max(max_dev, dev);
+  }
+  if (max_dev > kEffTolerance)
+  {
+    G4ExceptionDescription msg;
+    msg << "Efficiency table deviates from the QE spline by " << max_dev
+        << " (tolerance " << kEffTolerance << ")";
+    G4Exception("PMTSD::InitializeQESplines", "QETableTolerance", FatalException, msg);
+  }
 }
\ No newline at end of file
@@ -0,0 +1,211 @@
+#include "PhysicsTableCache.hh"
+#include "ConfManager.hh"
+
+#include "G4Material.hh"
+#include "G4MaterialPropertiesTable.hh"
+#include "G4ProductionCuts.hh"
+#include "G4Region.hh"
+#include "G4RegionStore.hh"
+#include "G4RunManager.hh"
+#include "G4VUserPhysicsList.hh"
+#include "G4Version.hh"
+#include "G4ios.hh"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+#include <utility>
+#include <vector>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+  // 64-bit FNV-1a
+  class Hasher
+  {
+  public:
+    void Add(const void *data, std::size_t size)
+    {
+      const auto *bytes = static_cast<const unsigned char *>(data);
+      for (std::size_t i = 0; i < size; ++i)
+      {
+        m_hash ^= bytes[i];
+        m_hash *= 1099511628211ULL;
+      }
+    }
+    void Add(G4double value) { Add(&value, sizeof(value)); }
+    void Add(G4int value) { Add(&value, sizeof(value)); }
+    void Add(const std::string &value)
+    {
+      Add(value.data(), value.size());
+      Add(static_cast<G4int>(value.size()));
+    }
+    std::uint64_t Get() const { return m_hash; }
+
+  private:
+    std::uint64_t m_hash = 14695981039346656037ULL;
+  };
+
+  G4bool Exists(const std::string &path)
+  {
+    struct stat st;
+    return stat(path.c_str(), &st) == 0;
+  }
+
+  void RemoveDirectory(const std::string &path)
+  {
+    std::error_code error;
+    std::filesystem::remove_all(path, error);
+    if (error)
+      G4cerr << "[PhysicsTableCache] Warning: cannot remove " << path << ": " << error.message() << G4endl;
+  }
+}
+
+const std::size_t PhysicsTableCache::kMaxEntries = 8;
+
+//_____________________________________________________________________________
+PhysicsTableCache::PhysicsTableCache(const std::string &root)
+    : m_root(root)
+{
+}
+
+//_____________________________________________________________________________
+G4String PhysicsTableCache::ComputeKey(const G4VUserPhysicsList *physics_list) const
+{
+  Hasher hash;
+  hash.Add(static_cast<G4int>(G4VERSION_NUMBER));
+
+  const auto &general = ConfManager::GetInstance().GetConfig().general;
+  hash.Add(general.physics_list);
+  hash.Add(general.em_option);
+  hash.Add(general.decay);
+
+  hash.Add(physics_list->GetDefaultCutValue());
+  for (const G4Region *region : *G4RegionStore::GetInstance())
+  {
+    hash.Add(std::string(region->GetName()));
+    const G4ProductionCuts *cuts = region->GetProductionCuts();
+    for (G4int i = 0; cuts && i < NumberOfG4CutIndex; ++i)
+      hash.Add(cuts->GetProductionCut(i));
+  }
+
+  for (const G4Material *material : *G4Material::GetMaterialTable())
+  {
+    hash.Add(std::string(material->GetName()));
+    hash.Add(material->GetDensity());
+    hash.Add(material->GetTemperature());
+    hash.Add(static_cast<G4int>(material->GetState()));
+    const G4double *fractions = material->GetFractionVector();
+    for (std::size_t i = 0; i < material->GetNumberOfElements(); ++i)
+    {
+      hash.Add(material->GetElement(i)->GetZ());
+      hash.Add(material->GetElement(i)->GetA());
+      hash.Add(fractions[i]);
+    }
+
+    const G4MaterialPropertiesTable *mpt = material->GetMaterialPropertiesTable();
+    if (!mpt)
+      continue;
+    const auto &names = mpt->GetMaterialPropertyNames();
+    const auto &properties = mpt->GetProperties();
+    for (std::size_t i = 0; i < properties.size(); ++i)
+    {
+      const G4MaterialPropertyVector *vector = properties[i];
+      if (!vector)
+        continue;
+      hash.Add(names[i]);
+      for (std::size_t j = 0; j < vector->GetVectorLength(); ++j)
+      {
+        hash.Add(vector->Energy(j));
+        hash.Add((*vector)[j]);
+      }
+    }
+    const auto &const_names = mpt->GetMaterialConstPropertyNames();
+    const auto &const_properties = mpt->GetConstProperties();
+    for (std::size_t i = 0; i < const_properties.size(); ++i)
+    {
+      if (!const_properties[i].second)
+        continue;
+      hash.Add(const_names[i]);
+      hash.Add(const_properties[i].first);
+    }
+  }
+
+  char key[17];
+  std::snprintf(key, sizeof(key), "%016llx", static_cast<unsigned long long>(hash.Get()));
+  return key;
+}
+
+//_____________________________________________________________________________
+void PhysicsTableCache::Setup(G4RunManager *run_manager, G4VUserPhysicsList *physics_list)
+{
+  const G4String key = ComputeKey(physics_list);
+  const std::string dir = m_root + "/" + key;
+  const std::string marker = dir + "/complete";
+
+  if (Exists(marker))
+  {
+    G4cout << "   Physics tables : retrieved from " << dir << G4endl;
+    physics_list->SetPhysicsTableRetrieved(dir);
+    // mark the entry as used, a read-only cache just keeps its order
+    std::error_code error;
+    std::filesystem::last_write_time(marker, std::filesystem::file_time_type::clock::now(), error);
+    return;
+  }
+
+  // build the tables now, then store them for the next jobs
+  run_manager->BeamOn(0);
+
+  // Jobs starting together may all miss: each writes a private directory
+  // and the first rename wins.
+  const std::string tmp = dir + ".tmp" + std::to_string(getpid());
+  mkdir(m_root.c_str(), 0755);
+  if (mkdir(tmp.c_str(), 0755) != 0 || !physics_list->StorePhysicsTable(tmp))
+  {
+    G4cerr << "[PhysicsTableCache] Warning: cannot store the physics tables in " << tmp << G4endl;
+    RemoveDirectory(tmp);
+    return;
+  }
+  std::ofstream(tmp + "/complete") << G4VERSION_TAG << "\n";
+  if (std::rename(tmp.c_str(), dir.c_str()) != 0)
+  {
+    RemoveDirectory(tmp);
+    return;
+  }
+  G4cout << "   Physics tables : stored in " << dir << G4endl;
+  Prune(key);
+}
+
+//_____________________________________________________________________________
+void PhysicsTableCache::Prune(const std::string &keep) const
+{
+  // entries are named by the bare key, the .tmp directories belong to
+  // running jobs
+  std::vector<std::pair<std::filesystem::file_time_type, std::filesystem::path>> entries;
+  std::error_code error;
+  for (const auto &entry : std::filesystem::directory_iterator(m_root, error))
+  {
+    const std::string name = entry.path().filename().string();
+    if (name == keep || name.find('.') != std::string::npos)
+      continue;
+    const auto used = std::filesystem::last_write_time(entry.path() / "complete", error);
+    if (!error)
+      entries.emplace_back(used, entry.path());
+  }
+  if (entries.size() < kMaxEntries)
+    return;
+
+  // most recently used first, keep kMaxEntries - 1 besides the new one
+  std::sort(entries.begin(), entries.end(),
+            [](const auto &a, const auto &b) { return a.first > b.first; });
+  for (std::size_t i = kMaxEntries - 1; i < entries.size(); ++i)
+  {
+    G4cout << "   Physics tables : removing old entry " << entries[i].second.string() << G4endl;
+    RemoveDirectory(entries[i].second.string());
+  }
+}
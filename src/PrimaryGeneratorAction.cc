@@ -1,5 +1,8 @@
 #include "PrimaryGeneratorAction.hh"
 #include "AnaManager.hh"
+#include "BeamProfile.hh"
+#include "JobRunManager.hh"
+#include "SeedStream.hh"
 #include "G4SystemOfUnits.hh"
 #include "G4ParticleGun.hh"
 #include "G4ParticleTable.hh"
@@ -9,9 +12,8 @@
 #include "G4PhysicalConstants.hh"
 #include "G4UnitsTable.hh"
 #include "G4LorentzVector.hh"
+#include "G4RunManager.hh"
 #include "Randomize.hh"
-#include "TFile.h"
-#include "TTree.h"
 #include "ConfManager.hh"
 
 namespace
@@ -20,21 +22,37 @@ namespace
   using CLHEP::GeV;
   using CLHEP::mm;
   const auto particleTable = G4ParticleTable::GetParticleTable();
-  auto &gAnaMan = AnaManager::GetInstance();
   auto &gConfMan = ConfManager::GetInstance();
 }
 
-PrimaryGeneratorAction::PrimaryGeneratorAction()
-    : G4VUserPrimaryGeneratorAction()
+PrimaryGeneratorAction::PrimaryGeneratorAction(AnaManager &anaMan)
+    : G4VUserPrimaryGeneratorAction(),
+      fAnaMan(anaMan)
 {
   fParticleGun = new G4ParticleGun(1);
+  Configure();
+}
+
+//_____________________________________________________________________________
+// Called again when /sac/conf/load or /sac/beamfile changed the configuration.
+void PrimaryGeneratorAction::Configure()
+{
+  fConfGeneration = gConfMan.GetGeneration();
+  const auto &conf = gConfMan.GetConfig();
+  fParticle = particleTable->FindParticle(conf.beam.particle);
+  if (!fParticle)
+  {
+    G4ExceptionDescription msg;
+    msg << "Unknown particle '" << conf.beam.particle << "'";
+    G4Exception("PrimaryGeneratorAction::Configure", "UnknownParticle", FatalException, msg);
+  }
+  fParticleGun->SetParticleDefinition(fParticle);
+  fParticleGun->SetParticleMomentumDirection(G4ThreeVector(0., 0., 1.));
 
-  static const G4String beamfile = "../conf/BeamProfile/" + gConfMan.Get("beamfile");
-  fBeamFile = TFile::Open(beamfile);
-  fBeamTree = (TTree *)fBeamFile->Get("beam");
-  fBeamTree->SetBranchAddress("x", &beam_x);
-  fBeamTree->SetBranchAddress("y", &beam_y);
-  fNEntries = fBeamTree->GetEntries();
+  fMomentum = conf.beam.momentum * GeV;
+  const auto &geom = conf.geometry;
+  fBeamZ = -geom.gel_size_z * mm / 2.0 - geom.teflon_thickness * mm - geom.blacksheet_thickness * mm - 10.0 * mm;
+  fBeamProfile = BeamProfile::Get();
 }
 
 PrimaryGeneratorAction::~PrimaryGeneratorAction()
@@ -44,60 +62,66 @@ PrimaryGeneratorAction::~PrimaryGeneratorAction()
 
 void PrimaryGeneratorAction::GeneratePrimaries(G4Event *anEvent)
 {
-  GenerateBeam(anEvent);
+  if (fConfGeneration != gConfMan.GetGeneration())
+    Configure();
+
+  // Each event has its own seed, so any event can be replayed alone with
+  // --replay <run seed> <event ID>, whatever the jobs and threads were.
+  const G4long eventID = anEvent->GetEventID() + JobRunManager::GetEventOffset();
+  const long seed = SeedStream::Derive(JobRunManager::GetRunSeed(), eventID, 1);
+  G4Random::setTheSeed(seed);
+  fAnaMan.SetEventSeed(seed);
+
+  GenerateBeam(anEvent, eventID);
   // GeneratePhoton(anEvent);
 }
 
-void PrimaryGeneratorAction::GenerateBeam(G4Event *anEvent)
+void PrimaryGeneratorAction::GenerateBeam(G4Event *anEvent, G4long eventID)
 {
-  static const G4String particle_name = gConfMan.Get("particle");
-  static const auto particle = particleTable->FindParticle(particle_name);
-  fParticleGun->SetParticleDefinition(particle);
+  // The beam entry follows the event ID so that worker threads sharing
+  // one run, and forked jobs, read disjoint entries.
+  BeamProfile::BeamEntry beam;
+  if (!fBeamProfile->Sample(eventID, beam))
+  {
+    // sequential sampling ran out: finish the run cleanly, this event is
+    // left empty and not written
+    G4cerr << "[PrimaryGeneratorAction] Warning: beam profile exhausted after "
+           << fBeamProfile->GetNumOfEntries() << " entries, aborting the run" << G4endl;
+    G4RunManager::GetRunManager()->AbortRun(true);
+    anEvent->SetEventAborted();
+    return;
+  }
 
   // -----------------------
   // Momentum
   // -----------------------
-  G4double p0 = gConfMan.GetDouble("momentum") * GeV;
-  G4double sigma_p = p0 * 0.02 / 2.355;
-  G4double momentum = G4RandGauss::shoot(p0, sigma_p);
+  // measured momentum if the beam file has one, else the nominal one smeared
+  G4double momentum = beam.p * GeV;
+  if (beam.p <= 0.f)
+  {
+    G4double p0 = fMomentum;
+    G4double sigma_p = p0 * 0.02 / 2.355;
+    momentum = G4RandGauss::shoot(p0, sigma_p);
+  }
 
-  G4double mass = particle->GetPDGMass();
+  G4double mass = fParticle->GetPDGMass();
   G4double energy = std::sqrt(mass * mass + momentum * momentum);
-  gAnaMan.SetBeamEnergy(energy);
+  fAnaMan.SetBeamEnergy(energy);
   fParticleGun->SetParticleEnergy(energy);
-
-  // -----------------------
-  // Momentum direction
-  // -----------------------
-  G4ThreeVector direction(0., 0., 1.);
-
-  // fParticleGun->SetParticleMomentum(momentum);
+  const G4ThreeVector direction = G4ThreeVector(beam.xp, beam.yp, 1.).unit();
   fParticleGun->SetParticleMomentumDirection(direction);
+  fAnaMan.SetBeamMomentum(momentum * direction);
 
   // -----------------------
   // Position
   // -----------------------
-  if (fCurrentEntry < fNEntries)
-  {
-    fBeamTree->GetEntry(fCurrentEntry++);
-  }
-  else
-  {
-    G4cerr << "[PrimaryGeneratorAction] Error: fCurrentEntry (" << fCurrentEntry << ") >= fNEntries (" << fNEntries << ")" << G4endl;
-    G4Exception("PrimaryGeneratorAction::GenerateBeam", "BeamEntryOverflow", FatalException, "Number of beam profile entries exceeded.");
-  }
-
-  G4double gel_z = gConfMan.GetDouble("gel_size_z") * mm;
-  G4double teflon_thickness = gConfMan.GetDouble("teflon_thickness") * mm;
-  G4double blacksheet_thickness = gConfMan.GetDouble("BlackSheet_thickness") * mm;
-
-  G4double x = beam_x * mm;
-  G4double y = beam_y * mm;
-  G4double z = -gel_z / 2.0 - teflon_thickness - blacksheet_thickness - 10.0 * mm;
+  G4double x = beam.x * mm;
+  G4double y = beam.y * mm;
+  G4double z = fBeamZ;
 
   G4ThreeVector position(x, y, z);
   fParticleGun->SetParticlePosition(position);
-  gAnaMan.SetBeamPosition(position);
+  fAnaMan.SetBeamPosition(position);
 
   // -----------------------
   // Gus
@@ -0,0 +1,123 @@
+#include "ProgressReporter.hh"
+
+#include <cstdio>
+#include <unistd.h>
+
+#include "G4ios.hh"
+
+namespace
+{
+  // resident set size from /proc, 0 where it is not available
+  G4double ResidentMemoryMB()
+  {
+    long pages = 0, resident = 0;
+    FILE *statm = std::fopen("/proc/self/statm", "r");
+    if (!statm)
+      return 0.;
+    if (std::fscanf(statm, "%ld %ld", &pages, &resident) != 2)
+      resident = 0;
+    std::fclose(statm);
+    return resident * static_cast<G4double>(sysconf(_SC_PAGESIZE)) / (1024. * 1024.);
+  }
+}
+
+//_____________________________________________________________________________
+ProgressReporter &ProgressReporter::GetInstance()
+{
+  static ProgressReporter instance;
+  return instance;
+}
+
+//_____________________________________________________________________________
+ProgressReporter::ProgressReporter()
+    : m_nevents(0),
+      m_interval_ns(0),
+      m_next_print_ns(0),
+      m_events(0),
+      m_photons(0),
+      m_pe(0),
+      m_startup_time(0.)
+{
+}
+
+//_____________________________________________________________________________
+void ProgressReporter::BeginOfRun(G4int nevents, G4double interval)
+{
+  m_start = Clock::now();
+  m_nevents = nevents;
+  m_interval_ns = static_cast<G4long>(interval * 1e9);
+  m_next_print_ns = m_interval_ns;
+  m_events = 0;
+  m_photons = 0;
+  m_pe = 0;
+  std::lock_guard<std::mutex> lock(m_channel_mutex);
+  m_npe_per_channel.clear();
+}
+
+//_____________________________________________________________________________
+void ProgressReporter::EndOfEvent(G4int tracked_photons, G4int detected_pe)
+{
+  m_photons.fetch_add(tracked_photons, std::memory_order_relaxed);
+  m_pe.fetch_add(detected_pe, std::memory_order_relaxed);
+  m_events.fetch_add(1, std::memory_order_relaxed);
+
+  if (m_interval_ns <= 0)
+    return;
+  const G4long now = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - m_start).count();
+  G4long next = m_next_print_ns.load(std::memory_order_relaxed);
+  if (now < next)
+    return;
+  // only the thread that moves the deadline prints
+  if (m_next_print_ns.compare_exchange_strong(next, now + m_interval_ns))
+    Print(false);
+}
+
+//_____________________________________________________________________________
+void ProgressReporter::MergeChannels(const std::vector<G4long> &npe_per_channel)
+{
+  std::lock_guard<std::mutex> lock(m_channel_mutex);
+  if (m_npe_per_channel.size() < npe_per_channel.size())
+    m_npe_per_channel.resize(npe_per_channel.size(), 0);
+  for (std::size_t i = 0; i < npe_per_channel.size(); ++i)
+    m_npe_per_channel[i] += npe_per_channel[i];
+}
+
+//_____________________________________________________________________________
+void ProgressReporter::EndOfRun()
+{
+  Print(true);
+
+  const G4long events = m_events.load(std::memory_order_relaxed);
+  if (events == 0)
+    return;
+  std::lock_guard<std::mutex> lock(m_channel_mutex);
+  G4cout << "   Startup time = " << m_startup_time << " s" << G4endl
+         << "   npe/event per channel :";
+  char value[32];
+  for (std::size_t i = 0; i < m_npe_per_channel.size(); ++i)
+  {
+    std::snprintf(value, sizeof(value), " %zu:%.4f", i, m_npe_per_channel[i] / static_cast<G4double>(events));
+    G4cout << value;
+  }
+  G4cout << G4endl;
+}
+
+//_____________________________________________________________________________
+void ProgressReporter::Print(G4bool final)
+{
+  const G4double elapsed = std::chrono::duration<G4double>(Clock::now() - m_start).count();
+  const G4long events = m_events.load(std::memory_order_relaxed);
+  const G4double rate = elapsed > 0. ? events / elapsed : 0.;
+
+  char line[256];
+  std::snprintf(line, sizeof(line),
+                "   %s %ld/%d events  %.1f ev/s  %.3g photons/s  %.3g pe/s",
+                final ? "Done    " : "Progress", events, m_nevents, rate,
+                elapsed > 0. ? m_photons.load(std::memory_order_relaxed) / elapsed : 0.,
+                elapsed > 0. ? m_pe.load(std::memory_order_relaxed) / elapsed : 0.);
+  G4cout << line;
+  if (!final && rate > 0.)
+    G4cout << "  ETA " << static_cast<G4long>((m_nevents - events) / rate) << " s";
+  std::snprintf(line, sizeof(line), "  RSS %.0f MB", ResidentMemoryMB());
+  G4cout << line << G4endl;
+}
@@ -0,0 +1,65 @@
+#include "RegionCuts.hh"
+
+#include "G4ProductionCuts.hh"
+#include "G4Region.hh"
+#include "G4RegionStore.hh"
+#include "G4RunManager.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4VUserPhysicsList.hh"
+
+namespace
+{
+  const char *const kRegionNames[RegionCuts::kNKinds] = {
+      "AerogelRegion", "PMTWindowRegion", "PassiveRegion", "SACAirRegion"};
+
+  G4ProductionCuts *gProductionCuts[RegionCuts::kNKinds] = {};
+
+  G4double CutOf(RegionCuts::Kind kind, const CutsConfig &cuts)
+  {
+    switch (kind)
+    {
+    case RegionCuts::kAerogel:
+      return cuts.aerogel;
+    case RegionCuts::kPMTWindow:
+      return cuts.pmt_window;
+    case RegionCuts::kPassive:
+      return cuts.passive;
+    default:
+      return cuts.air;
+    }
+  }
+}
+
+//_____________________________________________________________________________
+void RegionCuts::Create()
+{
+  auto store = G4RegionStore::GetInstance();
+  for (G4int k = 0; k < kNKinds; ++k)
+  {
+    if (gProductionCuts[k])
+      continue;
+    gProductionCuts[k] = new G4ProductionCuts();
+    store->FindOrCreateRegion(kRegionNames[k])->SetProductionCuts(gProductionCuts[k]);
+  }
+  Apply(ConfManager::GetInstance().GetConfig().cuts);
+}
+
+//_____________________________________________________________________________
+void RegionCuts::AddRoot(Kind kind, G4LogicalVolume *lv)
+{
+  G4RegionStore::GetInstance()->GetRegion(kRegionNames[kind])->AddRootLogicalVolume(lv);
+}
+
+//_____________________________________________________________________________
+void RegionCuts::Apply(const CutsConfig &cuts)
+{
+  const auto physics_list = G4RunManager::GetRunManager()->GetUserPhysicsList();
+  const G4double default_cut = physics_list ? physics_list->GetDefaultCutValue() : 0.7 * mm;
+  for (G4int k = 0; k < kNKinds; ++k)
+  {
+    if (!gProductionCuts[k])
+      continue;
+    const G4double cut = CutOf(static_cast<Kind>(k), cuts);
+    gProductionCuts[k]->SetProductionCut(cut > 0. ? cut * mm : default_cut);
+  }
+}
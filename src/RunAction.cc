@@ -1,26 +1,26 @@
 #include "RunAction.hh"
 #include "AnaManager.hh"
+#include "BoundaryValidation.hh"
+#include "ConfManager.hh"
+#include "JobRunManager.hh"
+#include "SeedStream.hh"
+#include "ProgressReporter.hh"
+#include "SACOpBoundaryProcess.hh"
 
 #include <fstream>
 
 #include <G4Run.hh>
 #include <G4RunManager.hh>
 #include <G4StateManager.hh>
+#include <G4Threading.hh>
 #include <G4Timer.hh>
 #include <G4UIterminal.hh>
 #include <G4UItcsh.hh>
 
-#include "AnaManager.hh"
-
-namespace
-{
-auto& gAnaMan = AnaManager::GetInstance();
-G4Timer timer;
-}
-
 //_____________________________________________________________________________
-RunAction::RunAction()
-  : G4UserRunAction()
+RunAction::RunAction(AnaManager& anaMan)
+  : G4UserRunAction(),
+    fAnaMan(anaMan)
 {
 }
 
@@ -34,18 +34,39 @@ void
 RunAction::BeginOfRunAction(const G4Run* aRun)
 {
   G4cout << "   Run# = " << aRun->GetRunID() << G4endl;
-  gAnaMan.BeginOfRunAction(aRun);
-  G4Random::setTheSeed(std::time(nullptr));
-  timer.Start();
+  // Workers are seeded from the master engine by the MT run manager. The
+  // run seed only depends on the base seed and the run, events reseed
+  // from it in PrimaryGeneratorAction.
+  if (G4Threading::IsMasterThread())
+  {
+    if (!JobRunManager::IsReplay())
+      JobRunManager::SetRunSeed(SeedStream::Derive(JobRunManager::GetBaseSeed(), 0, aRun->GetRunID()));
+    G4Random::setTheSeed(SeedStream::Derive(JobRunManager::GetRunSeed(),
+                                            JobRunManager::GetJobIndex(), 0));
+    G4cout << "   Run seed = " << JobRunManager::GetRunSeed() << G4endl;
+    ProgressReporter::GetInstance().BeginOfRun(aRun->GetNumberOfEventToBeProcessed(),
+                                               ConfManager::GetInstance().GetConfig().general.progress_interval);
+  }
+  fAnaMan.BeginOfRunAction(aRun);
+  fTimer.Start();
 }
 
 //_____________________________________________________________________________
 void
 RunAction::EndOfRunAction(const G4Run* aRun)
 {
-  timer.Stop();
-  gAnaMan.EndOfRunAction(aRun);
-  G4cout << "   Process end  = " << timer.GetClockTime()
+  fTimer.Stop();
+  fAnaMan.EndOfRunAction(aRun);
+  // workers finish before the master, which then has all channels merged
+  ProgressReporter::GetInstance().MergeChannels(fAnaMan.GetNumOfPEPerChannel());
+  if (auto boundary = SACOpBoundaryProcess::GetForThisThread())
+    boundary->FlushValidation();
+  if (G4Threading::IsMasterThread())
+  {
+    ProgressReporter::GetInstance().EndOfRun();
+    BoundaryValidation::GetInstance().Report();
+  }
+  G4cout << "   Process end  = " << fTimer.GetClockTime()
 	 << "   Event number = " << aRun->GetNumberOfEvent() << G4endl
-	 << "   Elapsed time = " << timer << G4endl << G4endl;
+	 << "   Elapsed time = " << fTimer << G4endl << G4endl;
 }
@@ -0,0 +1,292 @@
+#include "SACCerenkov.hh"
+#include "ConfManager.hh"
+#include "PMTSD.hh"
+
+#include "G4Electron.hh"
+#include "G4Material.hh"
+#include "G4OpticalPhoton.hh"
+#include "G4ParticleChange.hh"
+#include "G4PhysicalConstants.hh"
+#include "G4PhysicsModelCatalog.hh"
+#include "G4Poisson.hh"
+#include "G4ProcessTable.hh"
+#include "G4SDManager.hh"
+#include "G4Step.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4Threading.hh"
+#include "Randomize.hh"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+//_____________________________________________________________________________
+SACCerenkov::SACCerenkov()
+    : G4Cerenkov("Cerenkov"),
+      m_generation(0),
+      m_band(false),
+      m_band_min(0.),
+      m_band_max(0.),
+      m_secondary_id(G4PhysicsModelCatalog::GetModelID("model_Cerenkov")),
+      m_skipped_material(0),
+      m_skipped_band(0)
+{
+}
+
+//_____________________________________________________________________________
+SACCerenkov::~SACCerenkov()
+{
+}
+
+//_____________________________________________________________________________
+G4double SACCerenkov::AngleIntegral::Value(G4double e) const
+{
+  if (energy.empty())
+    return 0.;
+  if (e <= energy.front())
+    return value.front();
+  if (e >= energy.back())
+    return value.back();
+  const std::size_t i = std::upper_bound(energy.begin(), energy.end(), e) - energy.begin();
+  const G4double frac = (e - energy[i - 1]) / (energy[i] - energy[i - 1]);
+  return value[i - 1] + frac * (value[i] - value[i - 1]);
+}
+
+//_____________________________________________________________________________
+void SACCerenkov::BuildPhysicsTable(const G4ParticleDefinition &particle)
+{
+  G4Cerenkov::BuildPhysicsTable(particle);
+
+  // trapezoidal, like G4Cerenkov::BuildPhysicsTable
+  const auto materials = G4Material::GetMaterialTable();
+  m_integrals.assign(materials->size(), AngleIntegral());
+  for (const auto material : *materials)
+  {
+    const auto mpt = material->GetMaterialPropertiesTable();
+    const auto rindex = mpt ? mpt->GetProperty("RINDEX") : nullptr;
+    if (!rindex)
+      continue;
+    auto &integral = m_integrals[material->GetIndex()];
+    G4double sum = 0.;
+    for (std::size_t i = 0; i < rindex->GetVectorLength(); ++i)
+    {
+      if (i > 0)
+      {
+        const G4double n0 = (*rindex)[i - 1];
+        const G4double n1 = (*rindex)[i];
+        sum += (rindex->Energy(i) - rindex->Energy(i - 1)) * 0.5 * (1. / (n0 * n0) + 1. / (n1 * n1));
+      }
+      integral.energy.push_back(rindex->Energy(i));
+      integral.value.push_back(sum);
+    }
+  }
+}
+
+//_____________________________________________________________________________
+void SACCerenkov::StartTracking(G4Track *track)
+{
+  if (m_generation != ConfManager::GetInstance().GetGeneration())
+    Refresh();
+  G4Cerenkov::StartTracking(track);
+}
+
+//_____________________________________________________________________________
+void SACCerenkov::Refresh()
+{
+  const auto &conf_man = ConfManager::GetInstance();
+  m_generation = conf_man.GetGeneration();
+  const auto &optics = conf_man.GetConfig().optics;
+
+  m_emits.assign(G4Material::GetNumberOfMaterials(), optics.cerenkov_materials.empty());
+  for (const auto &name : optics.cerenkov_materials)
+  {
+    if (const auto material = G4Material::GetMaterial(name, false))
+      m_emits[material->GetIndex()] = true;
+    else if (G4Threading::G4GetThreadId() <= 0)
+      G4cerr << "[SACCerenkov] Warning: unknown material " << name << " in cerenkov_materials" << G4endl;
+  }
+
+  m_band = optics.cerenkov_band_pmt || optics.cerenkov_band_max > 0.;
+  m_band_min = optics.cerenkov_band_min * eV;
+  m_band_max = optics.cerenkov_band_max * eV;
+  if (optics.cerenkov_band_pmt)
+  {
+    const auto pmt_sd = dynamic_cast<PMTSD *>(G4SDManager::GetSDMpointer()->FindSensitiveDetector("PMT_SD", false));
+    if (!pmt_sd)
+      G4Exception("SACCerenkov::Refresh", "NoPMTSD", FatalException,
+                  "cerenkov_band pmt needs the PMT_SD sensitive detector.");
+    m_band_min = pmt_sd->GetEfficiencyMinEnergy();
+    m_band_max = pmt_sd->GetEfficiencyMaxEnergy();
+  }
+}
+
+//_____________________________________________________________________________
+G4bool SACCerenkov::Emits(const G4Material *material) const
+{
+  const std::size_t index = material->GetIndex();
+  return index >= m_emits.size() || m_emits[index];
+}
+
+//_____________________________________________________________________________
+G4double SACCerenkov::PostStepGetPhysicalInteractionLength(const G4Track &track, G4double previous_step_size,
+                                                           G4ForceCondition *condition)
+{
+  // still called on every step to count the skipped photons
+  if (!Emits(track.GetMaterial()))
+  {
+    *condition = StronglyForced;
+    return DBL_MAX;
+  }
+  return G4Cerenkov::PostStepGetPhysicalInteractionLength(track, previous_step_size, condition);
+}
+
+//_____________________________________________________________________________
+G4VParticleChange *SACCerenkov::PostStepDoIt(const G4Track &track, const G4Step &step)
+{
+  const G4Material *material = track.GetMaterial();
+  const G4bool emits = Emits(material);
+  if (emits && !m_band)
+    return G4Cerenkov::PostStepDoIt(track, step);
+
+  aParticleChange.Initialize(track);
+  aParticleChange.SetNumberOfSecondaries(0);
+  const auto mpt = material->GetMaterialPropertiesTable();
+  const auto rindex = mpt ? mpt->GetProperty("RINDEX") : nullptr;
+  if (!rindex)
+    return pParticleChange;
+  if (emits)
+    return BandPostStepDoIt(track, step, rindex);
+
+  const G4double charge = track.GetDefinition()->GetPDGCharge();
+  const G4double beta = 0.5 * (step.GetPreStepPoint()->GetBeta() + step.GetPostStepPoint()->GetBeta());
+  const G4double mean = GetAverageNumberOfPhotons(charge, beta, material, rindex) * step.GetStepLength();
+  if (mean > 0.)
+    m_skipped_material += G4int(G4Poisson(mean));
+  return pParticleChange;
+}
+
+//_____________________________________________________________________________
+// G4Cerenkov::GetAverageNumberOfPhotons over [m_band_min, m_band_max]
+G4double SACCerenkov::BandPhotonsPerLength(G4double charge, G4double beta, G4MaterialPropertyVector *rindex,
+                                           const AngleIntegral &integral) const
+{
+  constexpr G4double Rfact = 369.81 / (eV * cm);
+  if (beta <= 0.)
+    return 0.;
+  const G4double beta_inverse = 1. / beta;
+  if (rindex->GetMaxValue() < beta_inverse)
+    return 0.;
+
+  G4double emin = std::max(m_band_min, rindex->Energy(0));
+  const G4double emax = std::min(m_band_max, rindex->GetMaxEnergy());
+  // below threshold in part of the range, n is taken as monotonic
+  if (rindex->GetMinValue() <= beta_inverse)
+    emin = std::max(emin, rindex->GetEnergy(beta_inverse));
+  if (emax <= emin)
+    return 0.;
+
+  const G4double ge = integral.Value(emax) - integral.Value(emin);
+  return Rfact * charge / eplus * charge / eplus * ((emax - emin) - ge * beta_inverse * beta_inverse);
+}
+
+//_____________________________________________________________________________
+// G4Cerenkov::PostStepDoIt with the photon number and energies restricted to
+// the band
+G4VParticleChange *SACCerenkov::BandPostStepDoIt(const G4Track &track, const G4Step &step,
+                                                 G4MaterialPropertyVector *rindex)
+{
+  const G4Material *material = track.GetMaterial();
+  const AngleIntegral &integral = m_integrals[material->GetIndex()];
+  const G4StepPoint *pre = step.GetPreStepPoint();
+  const G4StepPoint *post = step.GetPostStepPoint();
+
+  const G4double charge = track.GetDefinition()->GetPDGCharge();
+  const G4double beta1 = pre->GetBeta();
+  const G4double beta2 = post->GetBeta();
+  const G4double beta = 0.5 * (beta1 + beta2);
+
+  const G4double mean_full = GetAverageNumberOfPhotons(charge, beta, material, rindex) * step.GetStepLength();
+  const G4double mean = BandPhotonsPerLength(charge, beta, rindex, integral) * step.GetStepLength();
+  if (mean_full > mean)
+    m_skipped_band += G4int(G4Poisson(mean_full - mean));
+  if (mean <= 0.)
+    return pParticleChange;
+
+  const G4double mean1 = BandPhotonsPerLength(charge, beta1, rindex, integral);
+  const G4double mean2 = BandPhotonsPerLength(charge, beta2, rindex, integral);
+  const G4int nphotons = G4int(G4Poisson(mean));
+  if (nphotons <= 0 || !GetStackPhotons() || std::max(mean1, mean2) < 1e-15)
+    return pParticleChange;
+
+  aParticleChange.SetNumberOfSecondaries(nphotons);
+  if (GetTrackSecondariesFirst() && track.GetTrackStatus() == fAlive)
+    aParticleChange.ProposeTrackStatus(fSuspend);
+
+  const G4ThreeVector x0 = pre->GetPosition();
+  const G4ThreeVector p0 = step.GetDeltaPosition().unit();
+  const G4double t0 = pre->GetGlobalTime();
+
+  const G4double pmin = std::max(m_band_min, rindex->Energy(0));
+  const G4double dp = std::min(m_band_max, rindex->GetMaxEnergy()) - pmin;
+  const G4double beta_inverse = 1. / beta;
+  const G4double max_cos = beta_inverse / rindex->GetMaxValue();
+  const G4double max_sin2 = (1.0 - max_cos) * (1.0 + max_cos);
+
+  for (G4int i = 0; i < nphotons; ++i)
+  {
+    G4double rand, sampled_energy, cos_theta, sin2_theta;
+    do
+    {
+      rand = G4UniformRand();
+      sampled_energy = pmin + rand * dp;
+      cos_theta = beta_inverse / rindex->Value(sampled_energy);
+      sin2_theta = (1.0 - cos_theta) * (1.0 + cos_theta);
+      rand = G4UniformRand();
+    } while (rand * max_sin2 > sin2_theta);
+
+    const G4double phi = twopi * G4UniformRand();
+    const G4double sin_phi = std::sin(phi);
+    const G4double cos_phi = std::cos(phi);
+    const G4double sin_theta = std::sqrt(sin2_theta);
+    G4ParticleMomentum photon_momentum(sin_theta * cos_phi, sin_theta * sin_phi, cos_theta);
+    photon_momentum.rotateUz(p0);
+    G4ThreeVector photon_polarization(cos_theta * cos_phi, cos_theta * sin_phi, -sin_theta);
+    photon_polarization.rotateUz(p0);
+
+    auto photon = new G4DynamicParticle(G4OpticalPhoton::OpticalPhoton(), photon_momentum);
+    photon->SetPolarization(photon_polarization);
+    photon->SetKineticEnergy(sampled_energy);
+
+    // position along the step, following the change of the yield
+    G4double number, n;
+    do
+    {
+      rand = G4UniformRand();
+      number = mean1 - rand * (mean1 - mean2);
+      n = G4UniformRand() * std::max(mean1, mean2);
+    } while (n > number);
+
+    const G4double delta = rand * step.GetStepLength();
+    const G4double delta_time = delta / (pre->GetVelocity() + rand * (post->GetVelocity() - pre->GetVelocity()) * 0.5);
+    auto secondary = new G4Track(photon, t0 + delta_time, x0 + rand * step.GetDeltaPosition());
+    secondary->SetTouchableHandle(pre->GetTouchableHandle());
+    secondary->SetParentID(track.GetTrackID());
+    secondary->SetCreatorModelID(m_secondary_id);
+    aParticleChange.AddSecondary(secondary);
+  }
+  return pParticleChange;
+}
+
+//_____________________________________________________________________________
+SACCerenkov *SACCerenkov::GetForThisThread()
+{
+  return dynamic_cast<SACCerenkov *>(
+      G4ProcessTable::GetProcessTable()->FindProcess("Cerenkov", G4Electron::Definition()));
+}
+
+//_____________________________________________________________________________
+void SACCerenkov::ResetCounters()
+{
+  m_skipped_material = 0;
+  m_skipped_band = 0;
+}
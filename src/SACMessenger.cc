@@ -0,0 +1,135 @@
+#include "SACMessenger.hh"
+#include "AnaManager.hh"
+#include "ConfManager.hh"
+#include "GeometryBenchmark.hh"
+#include "RegionCuts.hh"
+
+#include "G4ApplicationState.hh"
+#include "G4RunManager.hh"
+#include "G4StateManager.hh"
+#include "G4UIcmdWithAString.hh"
+#include "G4UIcmdWithAnInteger.hh"
+#include "G4UIdirectory.hh"
+
+#include "TROOT.h"
+
+#include <stdexcept>
+
+//_____________________________________________________________________________
+SACMessenger::SACMessenger()
+    : m_stepping_action(NeedsSteppingAction(ConfManager::GetInstance().GetConfig()))
+{
+  m_sac_dir = new G4UIdirectory("/sac/", false);
+  m_sac_dir->SetGuidance("SAC optical simulation control.");
+  m_conf_dir = new G4UIdirectory("/sac/conf/", false);
+  m_conf_dir->SetGuidance("Configuration file.");
+
+  m_load_cmd = new G4UIcmdWithAString("/sac/conf/load", this);
+  m_load_cmd->SetGuidance("Replace the configuration by a conf file.");
+  m_load_cmd->SetGuidance("The geometry is rebuilt only if it changed.");
+  m_load_cmd->SetParameterName("file", false);
+  m_load_cmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  m_load_cmd->SetToBeBroadcasted(false);
+
+  m_output_cmd = new G4UIcmdWithAString("/sac/output", this);
+  m_output_cmd->SetGuidance("Output rootfile of the next run.");
+  m_output_cmd->SetParameterName("path", false);
+  m_output_cmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  m_output_cmd->SetToBeBroadcasted(false);
+
+  m_beamfile_cmd = new G4UIcmdWithAString("/sac/beamfile", this);
+  m_beamfile_cmd->SetGuidance("Beam file of the next run, relative to conf/BeamProfile.");
+  m_beamfile_cmd->SetParameterName("file", false);
+  m_beamfile_cmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  m_beamfile_cmd->SetToBeBroadcasted(false);
+
+  m_bench_dir = new G4UIdirectory("/sac/bench/", false);
+  m_bench_dir->SetGuidance("Geometry benchmarks, the detector is not modified.");
+
+  m_bench_frame_cmd = new G4UIcmdWithAnInteger("/sac/bench/frame", this);
+  m_bench_frame_cmd->SetGuidance("Time locating a point and computing a step with the boolean");
+  m_bench_frame_cmd->SetGuidance("and the segmented Teflon frame, at n random points.");
+  m_bench_frame_cmd->SetParameterName("n", true);
+  m_bench_frame_cmd->SetDefaultValue(1000000);
+  m_bench_frame_cmd->SetRange("n > 0");
+  m_bench_frame_cmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  m_bench_frame_cmd->SetToBeBroadcasted(false);
+}
+
+//_____________________________________________________________________________
+SACMessenger::~SACMessenger()
+{
+  delete m_bench_frame_cmd;
+  delete m_bench_dir;
+  delete m_beamfile_cmd;
+  delete m_output_cmd;
+  delete m_load_cmd;
+  delete m_conf_dir;
+  delete m_sac_dir;
+}
+
+//_____________________________________________________________________________
+void SACMessenger::SetNewValue(G4UIcommand *command, G4String value)
+{
+  if (command == m_load_cmd)
+    LoadConfig(command, value);
+  else if (command == m_output_cmd)
+    AnaManager::SetOutputRootfilePath(value);
+  else if (command == m_beamfile_cmd)
+    ConfManager::GetInstance().SetBeamFile(value);
+  else if (command == m_bench_frame_cmd)
+    GeometryBenchmark::Frame(m_bench_frame_cmd->GetNewIntValue(value));
+}
+
+//_____________________________________________________________________________
+void SACMessenger::LoadConfig(G4UIcommand *command, const G4String &filename)
+{
+  auto &conf_man = ConfManager::GetInstance();
+  const SACConfig previous = conf_man.GetConfig();
+  try
+  {
+    conf_man.LoadConfigFile(filename);
+  }
+  catch (const std::exception &e)
+  {
+    // the previous configuration stays in place
+    G4ExceptionDescription msg;
+    msg << e.what();
+    command->CommandFailed(msg);
+    return;
+  }
+  const SACConfig &conf = conf_man.GetConfig();
+
+  // physics and thread setup are fixed at startup
+  if (conf.general.decay != previous.general.decay ||
+      conf.general.physics_list != previous.general.physics_list ||
+      conf.general.em_option != previous.general.em_option ||
+      conf.general.nthreads != previous.general.nthreads ||
+      conf.output.output_imt_threads != previous.output.output_imt_threads)
+  {
+    G4cerr << "[SACMessenger] Warning: decay, physics_list, em_option, nthreads and output_imt_threads from "
+           << filename << " are ignored, they only take effect at startup" << G4endl;
+  }
+  if (NeedsSteppingAction(conf) && !m_stepping_action)
+  {
+    G4cerr << "[SACMessenger] Warning: instrumentation, absorber_kill and the photon kill policies from "
+           << filename << " are ignored, the stepping action is only registered if one of them is on at startup"
+           << G4endl;
+  }
+  if (conf.output.async_output)
+    ROOT::EnableThreadSafety();
+
+  // the regions only exist after /run/initialize, they are created with the
+  // current cuts
+  if (CutsDiffer(previous, conf))
+    RegionCuts::Apply(conf.cuts);
+
+  // before /run/initialize the geometry is simply built from the new values
+  if (GeometryDiffers(previous, conf) &&
+      G4StateManager::GetStateManager()->GetCurrentState() == G4State_Idle)
+  {
+    // delete the old volumes and surfaces first so that lookups by name
+    // find the new ones; propagated to the worker threads
+    G4RunManager::GetRunManager()->ReinitializeGeometry(true);
+  }
+}
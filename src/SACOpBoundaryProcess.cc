@@ -0,0 +1,289 @@
+#include "SACOpBoundaryProcess.hh"
+
+#include "G4GeometryTolerance.hh"
+#include "G4LogicalBorderSurface.hh"
+#include "G4LogicalVolume.hh"
+#include "G4Navigator.hh"
+#include "G4OpProcessSubType.hh"
+#include "G4OpticalPhoton.hh"
+#include "G4OpticalSurface.hh"
+#include "G4ParticleChange.hh"
+#include "G4PhysicalConstants.hh"
+#include "G4PhysicalVolumeStore.hh"
+#include "G4ProcessManager.hh"
+#include "G4TransportationManager.hh"
+#include "G4VPhysicalVolume.hh"
+#include "Randomize.hh"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+
+namespace
+{
+  // G4ParticleChange::GetMomentumDirection() returns a pointer in older
+  // Geant4 versions and a reference in newer ones
+  const G4ThreeVector &Direction(const G4ThreeVector &direction) { return direction; }
+  const G4ThreeVector &Direction(const G4ThreeVector *direction) { return *direction; }
+
+  // Same distribution as G4LambertianRand: cos(theta) to the normal has the
+  // density 2 cos(theta), so cos(theta) = sqrt(u).
+  G4ThreeVector LambertianDirection(const G4ThreeVector &normal)
+  {
+    const G4double cos_theta = std::sqrt(G4UniformRand());
+    const G4double sin_theta = std::sqrt(1. - cos_theta * cos_theta);
+    const G4double phi = twopi * G4UniformRand();
+    G4ThreeVector direction(sin_theta * std::cos(phi), sin_theta * std::sin(phi), cos_theta);
+    return direction.rotateUz(normal);
+  }
+}
+
+//_____________________________________________________________________________
+SACOpBoundaryProcess::SACOpBoundaryProcess(G4OpBoundaryProcess *stock)
+    : G4WrapperProcess(stock->GetProcessName(), fOptical),
+      m_stock(stock),
+      m_mode(OpticsConfig::BoundaryStock),
+      m_generation(0),
+      m_world_id(-1),
+      m_tolerance(G4GeometryTolerance::GetInstance()->GetSurfaceTolerance()),
+      m_first_id(0),
+      m_nvolumes(0),
+      m_status(Undefined),
+      m_fast_last(false)
+{
+  SetProcessSubType(fOpBoundary);
+  RegisterProcess(stock);
+  m_stock_surface.kind = Surface::Stock;
+}
+
+//_____________________________________________________________________________
+// the stock process is deleted by G4WrapperProcess
+SACOpBoundaryProcess::~SACOpBoundaryProcess()
+{
+}
+
+//_____________________________________________________________________________
+void SACOpBoundaryProcess::StartTracking(G4Track *track)
+{
+  Refresh();
+  G4WrapperProcess::StartTracking(track);
+}
+
+//_____________________________________________________________________________
+// Configuration and geometry only change between runs, checking once per
+// track is enough. A rebuilt geometry has a new world volume.
+void SACOpBoundaryProcess::Refresh()
+{
+  const auto &conf_man = ConfManager::GetInstance();
+  const auto world = G4TransportationManager::GetTransportationManager()
+                         ->GetNavigatorForTracking()
+                         ->GetWorldVolume();
+  const G4int world_id = world ? world->GetInstanceID() : -1;
+  if (conf_man.GetGeneration() == m_generation && world_id == m_world_id)
+    return;
+  m_generation = conf_man.GetGeneration();
+  m_world_id = world_id;
+  m_mode = conf_man.GetConfig().optics.boundary;
+
+  // the cached surfaces may belong to deleted volumes
+  G4int min_id = INT_MAX, max_id = -1;
+  for (const auto pv : *G4PhysicalVolumeStore::GetInstance())
+  {
+    min_id = std::min(min_id, pv->GetInstanceID());
+    max_id = std::max(max_id, pv->GetInstanceID());
+  }
+  m_first_id = min_id;
+  m_nvolumes = max_id >= min_id ? max_id - min_id + 1 : 0;
+  m_surfaces.assign(std::size_t(m_nvolumes) * m_nvolumes, Surface());
+}
+
+//_____________________________________________________________________________
+const SACOpBoundaryProcess::Surface &
+SACOpBoundaryProcess::Find(const G4VPhysicalVolume *pre, const G4VPhysicalVolume *post)
+{
+  if (!pre || !post)
+    return m_stock_surface;
+  const G4int i = pre->GetInstanceID() - m_first_id;
+  const G4int j = post->GetInstanceID() - m_first_id;
+  if (i < 0 || i >= m_nvolumes || j < 0 || j >= m_nvolumes)
+    return m_stock_surface;
+  Surface &surface = m_surfaces[std::size_t(i) * m_nvolumes + j];
+  if (surface.kind == Surface::Unresolved)
+    surface = Resolve(pre, post);
+  return surface;
+}
+
+//_____________________________________________________________________________
+// Only border surfaces whose outcome does not depend on anything but the
+// surface table get a fast path. Skin surfaces, other models and finishes,
+// EFFICIENCY (detection) and complex refractive indices stay with the stock
+// process.
+SACOpBoundaryProcess::Surface
+SACOpBoundaryProcess::Resolve(const G4VPhysicalVolume *pre, const G4VPhysicalVolume *post)
+{
+  Surface surface;
+  surface.kind = Surface::Stock;
+
+  const auto border = G4LogicalBorderSurface::GetSurface(pre, post);
+  const auto optical = border ? dynamic_cast<G4OpticalSurface *>(border->GetSurfaceProperty()) : nullptr;
+  if (!optical || optical->GetType() != dielectric_dielectric || optical->GetModel() != unified)
+    return surface;
+
+  // without RINDEX before the surface the stock process kills the photon
+  const auto pre_mpt = pre->GetLogicalVolume()->GetMaterial()->GetMaterialPropertiesTable();
+  if (!pre_mpt || !pre_mpt->GetProperty("RINDEX"))
+    return surface;
+
+  const auto mpt = optical->GetMaterialPropertiesTable();
+  const auto finish = optical->GetFinish();
+  if (finish == groundbackpainted || finish == polishedbackpainted)
+  {
+    // the gap between surface and paint needs a RINDEX on the surface
+    if (!mpt || !mpt->GetProperty("RINDEX"))
+      surface.kind = Surface::BackPaintedNoRIndex;
+    return surface;
+  }
+  if (finish != groundfrontpainted && finish != polishedfrontpainted)
+    return surface;
+  if (!mpt || mpt->GetProperty("EFFICIENCY") ||
+      mpt->GetProperty("REALRINDEX") || mpt->GetProperty("IMAGINARYRINDEX"))
+    return surface;
+
+  surface.kind = Surface::FrontPainted;
+  surface.lambertian = finish == groundfrontpainted;
+  surface.reflectivity = mpt->GetProperty("REFLECTIVITY");
+  surface.transmittance = mpt->GetProperty("TRANSMITTANCE");
+  const auto post_mpt = post->GetLogicalVolume()->GetMaterial()->GetMaterialPropertiesTable();
+  if (post_mpt)
+    surface.groupvel = post_mpt->GetProperty("GROUPVEL");
+  return surface;
+}
+
+//_____________________________________________________________________________
+// Outward normal of the volume the photon leaves, turned against the photon.
+// No parallel worlds here, the tracking navigator limits every step.
+G4bool SACOpBoundaryProcess::SurfaceNormal(const G4ThreeVector &position, const G4ThreeVector &direction,
+                                           G4ThreeVector &normal) const
+{
+  G4bool valid = false;
+  normal = -G4TransportationManager::GetTransportationManager()
+                ->GetNavigatorForTracking()
+                ->GetGlobalExitNormal(position, &valid);
+  if (!valid)
+    return false;
+  if (direction * normal > 0.)
+    normal = -normal;
+  return true;
+}
+
+//_____________________________________________________________________________
+G4VParticleChange *SACOpBoundaryProcess::PostStepDoIt(const G4Track &track, const G4Step &step)
+{
+  m_fast_last = false;
+  const auto post_point = step.GetPostStepPoint();
+  if (m_mode == OpticsConfig::BoundaryStock || post_point->GetStepStatus() != fGeomBoundary ||
+      track.GetStepLength() <= m_tolerance)
+    return m_stock->PostStepDoIt(track, step);
+
+  const Surface &surface = Find(step.GetPreStepPoint()->GetPhysicalVolume(), post_point->GetPhysicalVolume());
+  G4ThreeVector normal;
+  // the stock process reports invalid normals
+  if (surface.kind == Surface::Stock ||
+      !SurfaceNormal(post_point->GetPosition(), track.GetMomentumDirection(), normal))
+    return m_stock->PostStepDoIt(track, step);
+
+  if (m_mode == OpticsConfig::BoundaryFast)
+  {
+    m_fast_last = true;
+    return FastPostStepDoIt(track, surface, normal);
+  }
+
+  // validate: both handle the photon, the stock result is propagated
+  const auto kind = surface.kind == Surface::FrontPainted ? BoundaryValidation::FrontPainted
+                                                          : BoundaryValidation::BackPaintedNoRIndex;
+  const auto fast_change = static_cast<G4ParticleChange *>(FastPostStepDoIt(track, surface, normal));
+  m_tallies.fast[kind].Add(m_status, Direction(fast_change->GetMomentumDirection()) * normal);
+  const auto stock_change = static_cast<G4ParticleChange *>(m_stock->PostStepDoIt(track, step));
+  m_tallies.stock[kind].Add(m_stock->GetStatus(), Direction(stock_change->GetMomentumDirection()) * normal);
+  return stock_change;
+}
+
+//_____________________________________________________________________________
+// What G4OpBoundaryProcess does for these surfaces, see Resolve()
+G4VParticleChange *SACOpBoundaryProcess::FastPostStepDoIt(const G4Track &track, const Surface &surface,
+                                                          const G4ThreeVector &normal)
+{
+  aParticleChange.Initialize(track);
+  aParticleChange.ProposeVelocity(track.GetVelocity());
+  const G4double energy = track.GetDynamicParticle()->GetTotalMomentum();
+
+  if (surface.kind == Surface::BackPaintedNoRIndex)
+  {
+    m_status = NoRINDEX;
+    aParticleChange.ProposeLocalEnergyDeposit(energy);
+    aParticleChange.ProposeTrackStatus(fStopAndKill);
+    return &aParticleChange;
+  }
+
+  const G4ThreeVector old_momentum = track.GetMomentumDirection();
+  const G4ThreeVector old_polarization = track.GetPolarization();
+  G4ThreeVector new_momentum = old_momentum;
+  G4ThreeVector new_polarization = old_polarization;
+
+  const G4double reflectivity = surface.reflectivity ? surface.reflectivity->Value(energy) : 1.;
+  const G4double transmittance = surface.transmittance ? surface.transmittance->Value(energy) : 0.;
+  const G4double rand = G4UniformRand();
+  if (rand > reflectivity + transmittance)
+  {
+    // no EFFICIENCY on these surfaces, nothing is detected
+    m_status = Absorption;
+    aParticleChange.ProposeLocalEnergyDeposit(0.);
+    aParticleChange.ProposeTrackStatus(fStopAndKill);
+  }
+  else if (rand > reflectivity)
+  {
+    m_status = Transmission;
+    if (surface.groupvel)
+      aParticleChange.ProposeVelocity(surface.groupvel->Value(energy));
+  }
+  else
+  {
+    G4ThreeVector facet_normal = normal;
+    if (surface.lambertian)
+    {
+      m_status = LambertianReflection;
+      new_momentum = LambertianDirection(normal);
+      facet_normal = (new_momentum - old_momentum).unit();
+    }
+    else
+    {
+      m_status = SpikeReflection;
+      new_momentum = old_momentum - 2. * (old_momentum * normal) * normal;
+    }
+    new_polarization = -old_polarization + 2. * (old_polarization * facet_normal) * facet_normal;
+  }
+
+  aParticleChange.ProposeMomentumDirection(new_momentum.unit());
+  aParticleChange.ProposePolarization(new_polarization.unit());
+  return &aParticleChange;
+}
+
+//_____________________________________________________________________________
+G4OpBoundaryProcessStatus SACOpBoundaryProcess::GetStatus() const
+{
+  return m_fast_last ? m_status : m_stock->GetStatus();
+}
+
+//_____________________________________________________________________________
+SACOpBoundaryProcess *SACOpBoundaryProcess::GetForThisThread()
+{
+  const auto manager = G4OpticalPhoton::Definition()->GetProcessManager();
+  return manager ? dynamic_cast<SACOpBoundaryProcess *>(manager->GetProcess("OpBoundary")) : nullptr;
+}
+
+//_____________________________________________________________________________
+void SACOpBoundaryProcess::FlushValidation()
+{
+  BoundaryValidation::GetInstance().Merge(m_tallies);
+  m_tallies = BoundaryValidation::Tallies();
+}
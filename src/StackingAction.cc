@@ -8,17 +8,31 @@
 #include "G4Track.hh"
 #include "G4ios.hh"
 #include "G4ClassificationOfNewTrack.hh"
+#include "G4Material.hh"
+#include "G4OpProcessSubType.hh"
+#include "G4PhysicalVolumeStore.hh"
+#include "G4Run.hh"
+#include "G4RunManager.hh"
+#include "G4SDManager.hh"
+#include "Randomize.hh"
 
 #include "AnaManager.hh"
+#include "ConfManager.hh"
+#include "PMTSD.hh"
+#include "SACCerenkov.hh"
 
-namespace
-{
-  auto &gAnaMan = AnaManager::GetInstance();
-}
+#include <algorithm>
 
-StackingAction::StackingAction()
+StackingAction::StackingAction(AnaManager &anaMan)
     : G4UserStackingAction(),
-      fScintillationAll(0), fCerenkovAll(0), fCerenkovAerogel(0)
+      fAnaMan(anaMan),
+      fScintillationAll(0), fCerenkovAll(0), fCerenkovAerogel(0), fTrackedPhotons(0),
+      fRunID(-1), fGelPV(nullptr),
+      fGlassIndex(-1), fTeflonIndex(-1), fPOMIndex(-1), fBlackSheetIndex(-1),
+      fPrefilter(false), fStage(0),
+      fQECulling(false),
+      fPMTSD(nullptr),
+      fSACCerenkov(nullptr)
 {
 }
 
@@ -34,15 +48,17 @@ StackingAction::ClassifyNewTrack(const G4Track *aTrack)
   { // particle is optical photon
     if (aTrack->GetParentID() > 0)
     { // particle is secondary
-      if (aTrack->GetCreatorProcess()->GetProcessName() == "Scintillation")
+      const G4int subType = aTrack->GetCreatorProcess()->GetProcessSubType();
+      if (subType == fScintillation)
         ++fScintillationAll;
-      else if (aTrack->GetCreatorProcess()->GetProcessName() == "Cerenkov")
+      else if (subType == fCerenkov)
       {
         ++fCerenkovAll;
 
         const G4VPhysicalVolume *volume = aTrack->GetVolume();
-        if (volume->GetName() == "GelPV")
+        if (volume == fGelPV)
           ++fCerenkovAerogel;
+        ++fCerenkovByMaterial[volume->GetLogicalVolume()->GetMaterial()->GetIndex()];
 
         // if (volume) {
         //   G4cout << "Cerenkov photon generated in volume: "
@@ -51,7 +67,19 @@ StackingAction::ClassifyNewTrack(const G4Track *aTrack)
         //   G4cout << "Cerenkov photon generated in an unknown volume" << G4endl;
         // }
       }
+
+      // Keep the photon with probability eff(E)/eff_max, PMTSD applies
+      // the remaining eff_max at detection. Counted above in any case.
+      if (fQECulling)
+      {
+        const G4double keep = fPMTSD->GetEfficiency(aTrack->GetKineticEnergy()) / fPMTSD->GetMaxEfficiency();
+        if (G4UniformRand() >= keep)
+          return fKill;
+      }
     }
+    ++fTrackedPhotons;
+    if (fPrefilter)
+      return fWaiting;
   }
 
   return fUrgent;
@@ -65,13 +93,90 @@ void StackingAction::NewStage()
   // 	 << fCerenkovAll << G4endl;
   // G4cout << "Number of Cerenkov photons produced in Quartz : "
   // 	 << fCerenkovAerogel << G4endl;
-  gAnaMan.SetNumOfCerenkovAll(fCerenkovAll);
-  gAnaMan.SetNumOfCerenkovAerogel(fCerenkovAerogel);
+  fAnaMan.SetNumOfCerenkovAll(fCerenkovAll);
+  fAnaMan.SetNumOfCerenkovAerogel(fCerenkovAerogel);
+  fAnaMan.SetNumOfCerenkovGlass(CerenkovInMaterial(fGlassIndex));
+  fAnaMan.SetNumOfCerenkovTeflon(CerenkovInMaterial(fTeflonIndex));
+  fAnaMan.SetNumOfCerenkovPOM(CerenkovInMaterial(fPOMIndex));
+  fAnaMan.SetNumOfCerenkovBlackSheet(CerenkovInMaterial(fBlackSheetIndex));
+
+  // the charged tracks are done, the waiting photons are now urgent
+  if (fPrefilter && ++fStage == 1 && fCerenkovAerogel == 0)
+  {
+    fTrackedPhotons = 0;
+    stackManager->clear();
+    fAnaMan.SetPrefiltered();
+  }
+  if (fSACCerenkov)
+  {
+    fAnaMan.SetNumOfCerenkovSkippedMaterial(fSACCerenkov->GetNumOfSkippedMaterial());
+    fAnaMan.SetNumOfCerenkovSkippedBand(fSACCerenkov->GetNumOfSkippedBand());
+  }
 }
 
 void StackingAction::PrepareNewEvent()
 {
+  const G4int runID = G4RunManager::GetRunManager()->GetCurrentRun()->GetRunID();
+  if (runID != fRunID)
+  {
+    fRunID = runID;
+    BeginOfRun();
+  }
+
   fScintillationAll = 0;
   fCerenkovAll = 0;
   fCerenkovAerogel = 0;
+  fTrackedPhotons = 0;
+  fStage = 0;
+  std::fill(fCerenkovByMaterial.begin(), fCerenkovByMaterial.end(), 0);
+  if (fSACCerenkov)
+    fSACCerenkov->ResetCounters();
+}
+
+//_____________________________________________________________________________
+// Resolve volume, material and SD identities once per run. The geometry and
+// the sensitive detector are built after the user actions are constructed,
+// and both may be rebuilt between runs.
+void StackingAction::BeginOfRun()
+{
+  fGelPV = G4PhysicalVolumeStore::GetInstance()->GetVolume("GelPV", false);
+  if (!fGelPV)
+    G4Exception("StackingAction::BeginOfRun", "NoGelPV", FatalException,
+                "GelPV is not in the geometry.");
+
+  fCerenkovByMaterial.assign(G4Material::GetNumberOfMaterials(), 0);
+  auto index_of = [](const G4String &name)
+  {
+    const G4Material *material = G4Material::GetMaterial(name, false);
+    return material ? static_cast<G4int>(material->GetIndex()) : -1;
+  };
+  fGlassIndex = index_of("Glass");
+  fTeflonIndex = index_of("Teflon");
+  fPOMIndex = index_of("POM");
+  fBlackSheetIndex = index_of("BlackSheet");
+
+  fSACCerenkov = SACCerenkov::GetForThisThread();
+
+  const auto &optics = ConfManager::GetInstance().GetConfig().optics;
+  fPrefilter = optics.event_prefilter;
+  if (fPrefilter && !optics.cerenkov_materials.empty() &&
+      std::find(optics.cerenkov_materials.begin(), optics.cerenkov_materials.end(), "Aerogel") ==
+          optics.cerenkov_materials.end())
+    G4Exception("StackingAction::BeginOfRun", "PrefilterNoAerogel", FatalException,
+                "event_prefilter needs Aerogel in cerenkov_materials.");
+
+  fQECulling = optics.qe_culling;
+  if (fQECulling)
+  {
+    fPMTSD = dynamic_cast<PMTSD *>(G4SDManager::GetSDMpointer()->FindSensitiveDetector("PMT_SD"));
+    if (!fPMTSD)
+      G4Exception("StackingAction::BeginOfRun", "NoPMTSD", FatalException,
+                  "qe_culling needs the PMT_SD sensitive detector.");
+  }
+}
+
+//_____________________________________________________________________________
+G4int StackingAction::CerenkovInMaterial(G4int index) const
+{
+  return index < 0 ? 0 : fCerenkovByMaterial[index];
 }
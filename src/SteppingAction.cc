@@ -3,14 +3,30 @@
 #include "G4Track.hh"
 #include "G4VProcess.hh"
 #include "G4OpticalPhoton.hh"
+#include "G4OpProcessSubType.hh"
+#include "G4Material.hh"
 #include "G4RunManager.hh"
 #include "G4SystemOfUnits.hh"
 #include "G4PhysicalConstants.hh"
-#include "G4SDManager.hh"
-#include "G4TouchableHandle.hh"
-#include "PMTSD.hh"
+#include "G4VTouchable.hh"
+#include "AnaManager.hh"
+#include "ConfManager.hh"
+#include "Instrumentation.hh"
+#include "SACOpBoundaryProcess.hh"
 
-SteppingAction::SteppingAction()
+#include <utility>
+
+SteppingAction::SteppingAction(AnaManager &anaMan)
+    : fAnaMan(anaMan),
+      fInstrumentation(Instrumentation::GetInstance()),
+      fGeneration(0),
+      fAbsorberKill(false),
+      fBoundary(nullptr),
+      fKillEscape(false),
+      fTimeGate(0.),
+      fMaxLength(0.),
+      fMaxBoundaries(0),
+      fBoundaries(0)
 {
 }
 
@@ -18,10 +34,106 @@ SteppingAction::~SteppingAction()
 {
 }
 
-// void SteppingAction::UserSteppingAction(const G4Step* step)
-// {
-// }
+//_____________________________________________________________________________
+void SteppingAction::Refresh()
+{
+  const auto &conf_man = ConfManager::GetInstance();
+  fGeneration = conf_man.GetGeneration();
+  const auto &optics = conf_man.GetConfig().optics;
+  fAbsorberKill = optics.absorber_kill;
+  fKillEscape = optics.photon_kill_escape;
+  fTimeGate = optics.photon_time_gate * ns;
+  fMaxLength = optics.photon_max_length * mm;
+  fMaxBoundaries = optics.photon_max_boundaries;
+
+  // materials are built once, see DetectorConstruction::Construct
+  fAbsorberOfMaterial.assign(G4Material::GetNumberOfMaterials(), kNoAbsorber);
+  const std::pair<const char *, Absorber> absorbers[] = {
+      {"BlackSheet", kBlackSheet}, {"Teflon", kTeflon}, {"POM", kPOM}};
+  for (const auto &absorber : absorbers)
+  {
+    if (const auto material = G4Material::GetMaterial(absorber.first, false))
+      fAbsorberOfMaterial[material->GetIndex()] = absorber.second;
+  }
+
+  fBoundary = SACOpBoundaryProcess::GetForThisThread();
+  if (fAbsorberKill && !fBoundary)
+    G4Exception("SteppingAction::Refresh", "NoSACOpBoundary", FatalException,
+                "absorber_kill needs the boundary process installed by SACOpticalPhysics.");
+}
+
+//_____________________________________________________________________________
+G4int SteppingAction::AbsorberOf(const G4Material *material) const
+{
+  const std::size_t index = material->GetIndex();
+  return index < fAbsorberOfMaterial.size() ? fAbsorberOfMaterial[index] : kNoAbsorber;
+}
+
+//_____________________________________________________________________________
+// kNoKill if the photon survives, else the first policy that kills it
+G4int SteppingAction::KillPolicyFor(const G4Track *track, const G4StepPoint *post) const
+{
+  // the world is the only volume outside SACMotherPV, a photon cannot come
+  // back from there
+  if (fKillEscape && post->GetPhysicalVolume() && post->GetTouchable()->GetHistoryDepth() == 0)
+    return kKillEscape;
+  if (fTimeGate > 0. && post->GetGlobalTime() > fTimeGate)
+    return kKillTimeGate;
+  if (fMaxLength > 0. && track->GetTrackLength() > fMaxLength)
+    return kKillMaxLength;
+  if (fMaxBoundaries > 0 && fBoundaries > fMaxBoundaries)
+    return kKillMaxBoundaries;
+  return kNoKill;
+}
 
+//_____________________________________________________________________________
 void SteppingAction::UserSteppingAction(const G4Step *step)
 {
+  if (fInstrumentation.IsEnabled())
+    fInstrumentation.Step(step);
+
+  G4Track *track = step->GetTrack();
+  if (track->GetDefinition() != G4OpticalPhoton::Definition())
+    return;
+  if (fGeneration != ConfManager::GetInstance().GetGeneration())
+    Refresh();
+
+  const G4StepPoint *post = step->GetPostStepPoint();
+  if (track->GetCurrentStepNumber() == 1)
+    fBoundaries = 0;
+  if (post->GetStepStatus() == fGeomBoundary)
+    ++fBoundaries;
+
+  if (track->GetTrackStatus() == fAlive)
+  {
+    // refracted or transmitted into an absorber: it would die in there
+    if (fAbsorberKill && post->GetStepStatus() == fGeomBoundary && post->GetMaterial())
+    {
+      const G4int absorber = AbsorberOf(post->GetMaterial());
+      const G4OpBoundaryProcessStatus status = fBoundary->GetStatus();
+      if (absorber != kNoAbsorber && (status == FresnelRefraction || status == Transmission))
+      {
+        track->SetTrackStatus(fStopAndKill);
+        fAnaMan.AddAbsorbedPhoton(absorber);
+        return;
+      }
+    }
+
+    const G4int policy = KillPolicyFor(track, post);
+    if (policy != kNoKill)
+    {
+      track->SetTrackStatus(fStopAndKill);
+      fAnaMan.AddKilledPhoton(policy);
+    }
+    return;
+  }
+
+  // absorbed in the bulk, also photons born in an absorber
+  const G4VProcess *process = post->GetProcessDefinedStep();
+  if (process && process->GetProcessSubType() == fOpAbsorption)
+  {
+    const G4int absorber = AbsorberOf(step->GetPreStepPoint()->GetMaterial());
+    if (absorber != kNoAbsorber)
+      fAnaMan.AddAbsorbedPhoton(absorber);
+  }
 }
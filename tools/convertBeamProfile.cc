@@ -0,0 +1,160 @@
+// Converts beam profile ROOT files (tree "beam") into one binary beam
+// phase-space file, see include/BeamPhaseSpace.hh.
+//
+//   convertBeamProfile [-xp branch] [-yp branch] [-p branch] output.bin input.root...
+//
+// The run number is taken from the digits before ".root", e.g.
+// KEKARrun00304.root is run 304. Branches x and y are required, missing
+// x', y' or p branches are written as 0.
+
+#include "BeamPhaseSpace.hh"
+
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "TFile.h"
+#include "TTree.h"
+
+using namespace BeamPhaseSpace;
+
+namespace
+{
+  int RunNumber(const std::string &path)
+  {
+    std::string::size_type end = path.rfind(".root");
+    if (end == std::string::npos)
+      end = path.size();
+    std::string::size_type begin = end;
+    while (begin > 0 && std::isdigit(static_cast<unsigned char>(path[begin - 1])))
+      --begin;
+    return begin == end ? -1 : std::atoi(path.substr(begin, end - begin).c_str());
+  }
+
+  // binds name to value if the tree has it, value stays 0 otherwise
+  void Bind(TTree *tree, const char *name, double &value)
+  {
+    value = 0.;
+    if (tree->GetBranch(name))
+    {
+      tree->SetBranchStatus(name, true);
+      tree->SetBranchAddress(name, &value);
+    }
+  }
+
+  bool Read(const std::string &path, const char *xp_name, const char *yp_name,
+            const char *p_name, std::vector<BeamEntry> &entries)
+  {
+    TFile *file = TFile::Open(path.c_str());
+    TTree *tree = file ? dynamic_cast<TTree *>(file->Get("beam")) : nullptr;
+    if (!tree || !tree->GetBranch("x") || !tree->GetBranch("y"))
+    {
+      std::fprintf(stderr, "Error: %s has no beam tree with x and y\n", path.c_str());
+      delete file;
+      return false;
+    }
+
+    double x, y, xp, yp, p;
+    tree->SetBranchStatus("*", false);
+    Bind(tree, "x", x);
+    Bind(tree, "y", y);
+    Bind(tree, xp_name, xp);
+    Bind(tree, yp_name, yp);
+    Bind(tree, p_name, p);
+
+    const Long64_t nentries = tree->GetEntries();
+    entries.reserve(nentries);
+    for (Long64_t i = 0; i < nentries; ++i)
+    {
+      tree->GetEntry(i);
+      entries.push_back({static_cast<float>(x), static_cast<float>(y), static_cast<float>(xp),
+                         static_cast<float>(yp), static_cast<float>(p)});
+    }
+    delete file;
+    return true;
+  }
+}
+
+int main(int argc, char **argv)
+{
+  const char *xp_name = "xp";
+  const char *yp_name = "yp";
+  const char *p_name = "p";
+  int arg = 1;
+  for (; arg + 1 < argc && argv[arg][0] == '-'; arg += 2)
+  {
+    if (!std::strcmp(argv[arg], "-xp"))
+      xp_name = argv[arg + 1];
+    else if (!std::strcmp(argv[arg], "-yp"))
+      yp_name = argv[arg + 1];
+    else if (!std::strcmp(argv[arg], "-p"))
+      p_name = argv[arg + 1];
+    else
+      break;
+  }
+  if (argc - arg < 2)
+  {
+    std::fprintf(stderr, "Usage: %s [-xp branch] [-yp branch] [-p branch] output.bin input.root...\n", argv[0]);
+    return 1;
+  }
+  const std::string output = argv[arg++];
+
+  std::vector<BeamRunIndex> index;
+  std::vector<std::vector<BeamEntry>> runs;
+  for (; arg < argc; ++arg)
+  {
+    const int run = RunNumber(argv[arg]);
+    if (run < 0)
+    {
+      std::fprintf(stderr, "Error: no run number in %s\n", argv[arg]);
+      return 1;
+    }
+    for (const auto &known : index)
+    {
+      if (known.run == run)
+      {
+        std::fprintf(stderr, "Error: run %d given twice\n", run);
+        return 1;
+      }
+    }
+    runs.emplace_back();
+    if (!Read(argv[arg], xp_name, yp_name, p_name, runs.back()))
+      return 1;
+    index.push_back({run, 0, 0, runs.back().size()});
+  }
+
+  BeamFileHeader header;
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.nruns = static_cast<std::uint32_t>(index.size());
+  header.entry_size = sizeof(BeamEntry);
+  std::uint64_t offset = sizeof(header) + index.size() * sizeof(BeamRunIndex);
+  for (auto &entry : index)
+  {
+    entry.offset = offset;
+    offset += entry.nentries * sizeof(BeamEntry);
+  }
+
+  FILE *out = std::fopen(output.c_str(), "wb");
+  if (!out)
+  {
+    std::fprintf(stderr, "Error: cannot write %s\n", output.c_str());
+    return 1;
+  }
+  bool ok = std::fwrite(&header, sizeof(header), 1, out) == 1 &&
+            std::fwrite(index.data(), sizeof(BeamRunIndex), index.size(), out) == index.size();
+  for (const auto &entries : runs)
+    ok = ok && std::fwrite(entries.data(), sizeof(BeamEntry), entries.size(), out) == entries.size();
+  ok = (std::fclose(out) == 0) && ok;
+  if (!ok)
+  {
+    std::fprintf(stderr, "Error: write to %s failed\n", output.c_str());
+    return 1;
+  }
+
+  for (const auto &entry : index)
+    std::printf("run %d: %llu entries\n", entry.run, static_cast<unsigned long long>(entry.nentries));
+  return 0;
+}